@@ -1,21 +0,0 @@
-#pragma once
-
-#include "noncopyable.h"
-
-#include <thread>
-#include <mutex>
-#include <condition_variable>
-
-class CountDownLatch: public noncopyable
-{
-public:
-    explicit CountDownLatch(int count);
-    void wait();
-    void countDown();
-    int getCount();
-
-private:
-    int count_;
-    std::mutex mutex_;
-    std::condition_variable cond_;
-};
\ No newline at end of file
@@ -1,31 +0,0 @@
-#pragma once
-#include <functional>
-#include <mutex>
-#include <condition_variable>
-#include "noncopyable.h"
-#include "Thread.h"
-
-class EventLoop;
-
-class EventLoopThread: noncopyable
-{
-public:
-    using ThreadInitCallback = std::function<void(EventLoop *)>;
-
-    EventLoopThread(const ThreadInitCallback &cb = ThreadInitCallback(), 
-            const std::string &name = std::string());
-    ~EventLoopThread();
-
-    EventLoop *startLoop();
-
-private:
-    void threadFunc();
-
-private:
-    EventLoop *loop_;
-    bool exiting_;
-    Thread thread_;
-    std::mutex mutex_;
-    std::condition_variable cond_;
-    ThreadInitCallback callback_;
-};
\ No newline at end of file
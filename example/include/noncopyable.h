@@ -1,11 +0,0 @@
-#pragma once
-
-class noncopyable
-{
-public:
-    noncopyable(const noncopyable &) = delete;
-    noncopyable &operator=(const noncopyable &) = delete;
-protected:
-    noncopyable() = default;
-    ~noncopyable() = default;
-};
\ No newline at end of file
@@ -0,0 +1,227 @@
+#include "CpuAffinity.h"
+#include "Logger.h"
+
+#include <sched.h>
+#include <errno.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <fstream>
+#include <tuple>
+
+namespace
+{
+const char *const kCpuPath = "/sys/devices/system/cpu";
+const char *const kNodePath = "/sys/devices/system/node";
+
+// 读取sysfs文件的第一行，失败返回false
+bool readLine(const std::string &path, std::string *line)
+{
+    std::ifstream in(path);
+    return static_cast<bool>(std::getline(in, *line));
+}
+
+// 读取sysfs中的整数，失败返回defaultValue
+int readInt(const std::string &path, int defaultValue)
+{
+    std::string line;
+    if (!readLine(path, &line) || line.empty())
+    {
+        return defaultValue;
+    }
+    return atoi(line.c_str());
+}
+
+std::string cpuFile(int cpu, const char *name)
+{
+    char buf[128];
+    snprintf(buf, sizeof(buf), "%s/cpu%d/topology/%s", kCpuPath, cpu, name);
+    return buf;
+}
+
+// 只保留进程允许运行的CPU
+CpuAffinity::CpuSet intersect(const CpuAffinity::CpuSet &cpus)
+{
+    CpuAffinity::CpuSet allowed = CpuAffinity::allowedCpus();
+    CpuAffinity::CpuSet result;
+    for (int cpu: cpus)
+    {
+        if (std::binary_search(allowed.begin(), allowed.end(), cpu))
+        {
+            result.push_back(cpu);
+        }
+    }
+    return result;
+}
+}
+
+CpuAffinity::CpuSet CpuAffinity::parseCpuList(const std::string &list)
+{
+    CpuSet cpus;
+    size_t pos = 0;
+    while (pos < list.size())
+    {
+        size_t end = list.find(',', pos);
+        if (end == std::string::npos)
+        {
+            end = list.size();
+        }
+        std::string item = list.substr(pos, end - pos);
+        int first = 0;
+        int last = 0;
+        int matched = sscanf(item.c_str(), "%d-%d", &first, &last);
+        if (matched == 1)
+        {
+            last = first;
+        }
+        if (matched >= 1 && first >= 0 && first <= last)
+        {
+            for (int cpu = first; cpu <= last; cpu++)
+            {
+                cpus.push_back(cpu);
+            }
+        }
+        pos = end + 1;
+    }
+    std::sort(cpus.begin(), cpus.end());
+    cpus.erase(std::unique(cpus.begin(), cpus.end()), cpus.end());
+    return cpus;
+}
+
+CpuAffinity::CpuSet CpuAffinity::allowedCpus()
+{
+    CpuSet cpus;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (::sched_getaffinity(0, sizeof(set), &set) < 0)
+    {
+        LOG_ERROR << "CpuAffinity::allowedCpus sched_getaffinity errno=" << errno;
+        return cpus;
+    }
+    for (int cpu = 0; cpu < CPU_SETSIZE; cpu++)
+    {
+        if (CPU_ISSET(cpu, &set))
+        {
+            cpus.push_back(cpu);
+        }
+    }
+    return cpus;
+}
+
+CpuAffinity::CpuSet CpuAffinity::physicalCores()
+{
+    // (节点, 封装, 核)相同的逻辑CPU是同一个物理核的超线程，allowedCpus升序，第一个就是编号最小的
+    using CoreKey = std::tuple<int, int, int>;
+    std::vector<std::pair<CoreKey, int>> cores;
+    for (int cpu: allowedCpus())
+    {
+        CoreKey key(nodeOfCpu(cpu),
+                readInt(cpuFile(cpu, "physical_package_id"), 0),
+                readInt(cpuFile(cpu, "core_id"), cpu));
+        bool seen = false;
+        for (const auto &core: cores)
+        {
+            if (core.first == key)
+            {
+                seen = true;
+                break;
+            }
+        }
+        if (!seen)
+        {
+            cores.push_back(std::make_pair(key, cpu));
+        }
+    }
+    std::sort(cores.begin(), cores.end());
+
+    CpuSet result;
+    for (const auto &core: cores)
+    {
+        result.push_back(core.second);
+    }
+    return result;
+}
+
+std::vector<int> CpuAffinity::numaNodes()
+{
+    std::string line;
+    std::vector<int> nodes;
+    if (readLine(std::string(kNodePath) + "/has_cpu", &line))
+    {
+        for (int node: parseCpuList(line))
+        {
+            if (!nodeCpus(node).empty())
+            {
+                nodes.push_back(node);
+            }
+        }
+    }
+    if (nodes.empty())
+    {
+        nodes.push_back(0);
+    }
+    return nodes;
+}
+
+CpuAffinity::CpuSet CpuAffinity::nodeCpus(int node)
+{
+    char path[128];
+    snprintf(path, sizeof(path), "%s/node%d/cpulist", kNodePath, node);
+    std::string line;
+    if (!readLine(path, &line))
+    {
+        return node == 0 ? allowedCpus() : CpuSet();
+    }
+    return intersect(parseCpuList(line));
+}
+
+int CpuAffinity::nodeOfCpu(int cpu)
+{
+    // 在各节点的cpulist中查找
+    std::string line;
+    if (!readLine(std::string(kNodePath) + "/has_cpu", &line))
+    {
+        return 0;
+    }
+    for (int node: parseCpuList(line))
+    {
+        char path[128];
+        snprintf(path, sizeof(path), "%s/node%d/cpulist", kNodePath, node);
+        std::string cpulist;
+        if (readLine(path, &cpulist))
+        {
+            CpuSet cpus = parseCpuList(cpulist);
+            if (std::binary_search(cpus.begin(), cpus.end(), cpu))
+            {
+                return node;
+            }
+        }
+    }
+    return 0;
+}
+
+bool CpuAffinity::bindCurrentThread(const CpuSet &cpus)
+{
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int cpu: cpus)
+    {
+        if (cpu >= 0 && cpu < CPU_SETSIZE)
+        {
+            CPU_SET(cpu, &set);
+        }
+    }
+    int err = ::pthread_setaffinity_np(::pthread_self(), sizeof(set), &set);
+    if (err != 0)
+    {
+        LOG_ERROR << "CpuAffinity::bindCurrentThread pthread_setaffinity_np error=" << err;
+        return false;
+    }
+    return true;
+}
+
+int CpuAffinity::currentCpu()
+{
+    return ::sched_getcpu();
+}
@@ -0,0 +1,32 @@
+#pragma once
+#include <string>
+#include <vector>
+
+/**
+ * @brief
+ * CPU拓扑查询和线程绑核，拓扑信息来自/sys/devices/system
+ * 返回的CPU都和当前进程允许运行的CPU（taskset、cgroup限制后的）取交集
+ */
+class CpuAffinity
+{
+public:
+    using CpuSet = std::vector<int>;
+
+    // 解析"0-3,8,10-11"格式的CPU列表，格式错误的部分被忽略
+    static CpuSet parseCpuList(const std::string &list);
+    // 当前进程允许运行的CPU，升序
+    static CpuSet allowedCpus();
+    // 每个物理核取一个逻辑CPU（超线程兄弟中编号最小的），按NUMA节点、物理封装、核编号排序
+    static CpuSet physicalCores();
+    // 有可用CPU的NUMA节点编号，没有NUMA信息时返回{0}
+    static std::vector<int> numaNodes();
+    // NUMA节点node上可用的CPU，没有NUMA信息时node 0返回所有可用CPU
+    static CpuSet nodeCpus(int node);
+    // cpu所在的NUMA节点，未知时返回0
+    static int nodeOfCpu(int cpu);
+
+    // 把调用线程绑定到cpus，失败时记录错误日志并返回false
+    static bool bindCurrentThread(const CpuSet &cpus);
+    // 调用线程当前运行的CPU
+    static int currentCpu();
+};
@@ -0,0 +1,202 @@
+#pragma once
+
+#include <functional>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <cstddef>
+
+template<typename Signature, size_t Capacity = 64>
+class InplaceFunction;
+
+/**
+ * @brief
+ * 只能移动的可调用对象包装，用法与std::function相同
+ * 可调用对象不超过Capacity字节时直接放在内部的存储中，构造、移动都不分配内存；
+ * libstdc++的std::function只内联16字节，std::bind一个成员函数指针加一个shared_ptr就超过了，
+ * 每次投递回调都会malloc一次
+ * 超过Capacity的对象退化为堆上分配，保证任意可调用对象都能使用
+ * 调用空对象抛出std::bad_function_call
+ */
+template<typename R, typename... Args, size_t Capacity>
+class InplaceFunction<R(Args...), Capacity>
+{
+public:
+    static const size_t kCapacity = Capacity;
+
+    InplaceFunction() noexcept: invoke_(nullptr), manage_(nullptr) {}
+    InplaceFunction(std::nullptr_t) noexcept: invoke_(nullptr), manage_(nullptr) {}
+
+    template<typename F,
+            typename = typename std::enable_if<
+                    !std::is_same<typename std::decay<F>::type, InplaceFunction>::value>::type>
+    InplaceFunction(F &&f)
+            : invoke_(nullptr)
+            , manage_(nullptr)
+    {
+        using Functor = typename std::decay<F>::type;
+        if (isNull(f))
+        {
+            return;
+        }
+        construct<Functor>(std::forward<F>(f), std::integral_constant<bool, fitsInline<Functor>()>());
+    }
+
+    InplaceFunction(InplaceFunction &&other) noexcept
+            : invoke_(nullptr)
+            , manage_(nullptr)
+    {
+        moveFrom(other);
+    }
+
+    InplaceFunction &operator=(InplaceFunction &&other) noexcept
+    {
+        if (this != &other)
+        {
+            reset();
+            moveFrom(other);
+        }
+        return *this;
+    }
+
+    InplaceFunction &operator=(std::nullptr_t) noexcept
+    {
+        reset();
+        return *this;
+    }
+
+    template<typename F,
+            typename = typename std::enable_if<
+                    !std::is_same<typename std::decay<F>::type, InplaceFunction>::value>::type>
+    InplaceFunction &operator=(F &&f)
+    {
+        InplaceFunction tmp(std::forward<F>(f));
+        reset();
+        moveFrom(tmp);
+        return *this;
+    }
+
+    InplaceFunction(const InplaceFunction &) = delete;
+    InplaceFunction &operator=(const InplaceFunction &) = delete;
+
+    ~InplaceFunction() { reset(); }
+
+    explicit operator bool() const noexcept { return invoke_ != nullptr; }
+
+    R operator()(Args... args) const
+    {
+        if (invoke_ == nullptr)
+        {
+            throw std::bad_function_call();
+        }
+        return invoke_(const_cast<void *>(static_cast<const void *>(&storage_)), std::forward<Args>(args)...);
+    }
+
+private:
+    enum Operation
+    {
+        kMove,      // 把src中的对象移动到dst，并析构src中的对象
+        kDestroy,
+    };
+
+    using Storage = typename std::aligned_storage<Capacity, alignof(std::max_align_t)>::type;
+    using Invoker = R (*)(void *, Args &&...);
+    using Manager = void (*)(Operation, void *, void *);
+
+    template<typename F>
+    static constexpr bool fitsInline()
+    {
+        return sizeof(F) <= Capacity
+                && alignof(std::max_align_t) % alignof(F) == 0
+                && std::is_nothrow_move_constructible<F>::value;
+    }
+
+    template<typename F>
+    static bool isNull(const F &) { return false; }
+    template<typename Sig>
+    static bool isNull(const std::function<Sig> &f) { return !f; }
+    template<typename Ret, typename... A>
+    static bool isNull(Ret (*f)(A...)) { return f == nullptr; }
+
+    // 内联存储
+    template<typename F, typename Arg>
+    void construct(Arg &&f, std::true_type)
+    {
+        ::new (static_cast<void *>(&storage_)) F(std::forward<Arg>(f));
+        invoke_ = &invokeInline<F>;
+        manage_ = &manageInline<F>;
+    }
+
+    // 堆上存储，storage_中只放指针
+    template<typename F, typename Arg>
+    void construct(Arg &&f, std::false_type)
+    {
+        *reinterpret_cast<F **>(&storage_) = new F(std::forward<Arg>(f));
+        invoke_ = &invokeHeap<F>;
+        manage_ = &manageHeap<F>;
+    }
+
+    template<typename F>
+    static R invokeInline(void *p, Args &&...args)
+    {
+        return (*static_cast<F *>(p))(std::forward<Args>(args)...);
+    }
+
+    template<typename F>
+    static void manageInline(Operation op, void *dst, void *src)
+    {
+        F *f = static_cast<F *>(src);
+        if (op == kMove)
+        {
+            ::new (dst) F(std::move(*f));
+        }
+        f->~F();
+    }
+
+    template<typename F>
+    static R invokeHeap(void *p, Args &&...args)
+    {
+        return (**static_cast<F **>(p))(std::forward<Args>(args)...);
+    }
+
+    template<typename F>
+    static void manageHeap(Operation op, void *dst, void *src)
+    {
+        F **f = static_cast<F **>(src);
+        if (op == kMove)
+        {
+            *static_cast<F **>(dst) = *f;
+        }
+        else
+        {
+            delete *f;
+        }
+    }
+
+    void moveFrom(InplaceFunction &other) noexcept
+    {
+        if (other.invoke_)
+        {
+            other.manage_(kMove, &storage_, &other.storage_);
+            invoke_ = other.invoke_;
+            manage_ = other.manage_;
+            other.invoke_ = nullptr;
+            other.manage_ = nullptr;
+        }
+    }
+
+    void reset() noexcept
+    {
+        if (invoke_)
+        {
+            manage_(kDestroy, nullptr, &storage_);
+            invoke_ = nullptr;
+            manage_ = nullptr;
+        }
+    }
+
+private:
+    Storage storage_;
+    Invoker invoke_;
+    Manager manage_;
+};
@@ -1,14 +1,27 @@
 #include "Logger.h"
 #include "AsyncLogging.h"
+#include <stdlib.h>
+#include <string.h>
 
 std::vector<std::string> Logger::LevelMap = 
 {
+    "DEBUG",
     "INFO",
     "ERROR",
-    "DEBUF",
     "FATAL",
 };
 
+static Logger::LogLevel initLogLevel()
+{
+    if (::getenv("MUDUO_LOG_DEBUG"))
+    {
+        return Logger::DEBUG;
+    }
+    return Logger::INFO;
+}
+
+Logger::LogLevel g_logLevel = initLogLevel();
+
 void defaultOutput(const char *buf, size_t len)
 {
     ::fwrite(buf, 1, len, stdout);
@@ -42,7 +55,13 @@ void Logger::setOutputFunc(OutputFunc func)
     LogOutputFunc = func;
 }
 
-std::string Logger::getFileName(const char *name)
+void Logger::setLogLevel(LogLevel level)
+{
+    g_logLevel = level;
+}
+
+// 返回路径中的文件名部分，不拷贝
+const char *Logger::getFileName(const char *name)
 {
     const char *slash = strrchr(name, '/');
     if (slash)
@@ -14,12 +14,14 @@ class Logger: public noncopyable
 public:
     using OutputFunc = std::function<void(const char *, size_t)>;
 
+    // 级别从低到高，取值与MYMUDUO_MIN_LOG_LEVEL一致
     enum LogLevel
     {
-        INFO = 0,
+        DEBUG = 0,
+        INFO,
         ERROR,
-        DEBUG,
         FATAL,
+        NUM_LOG_LEVELS,
     };
 
     static std::vector<std::string> LevelMap;
@@ -27,6 +29,12 @@ public:
 
     static void setOutputFunc(OutputFunc func);
 
+    // 运行时的日志级别，低于该级别的日志在构造Logger之前就被跳过
+    // 默认为INFO，设置环境变量MUDUO_LOG_DEBUG时为DEBUG
+    // 应该在启动时设置，不保证与其他线程中正在输出的日志同步
+    static LogLevel logLevel();
+    static void setLogLevel(LogLevel level);
+
 
 public:
     Logger(const char *fileName, unsigned int lineno,  const char *funcName, LogLevel level);
@@ -39,7 +47,7 @@ public:
     }
 
 private:
-    std::string getFileName(const char *name);
+    static const char *getFileName(const char *name);
 
 private:
     unsigned int lineno_;
@@ -48,14 +56,26 @@ private:
     Timestamp timestamp_;
 };
 
-#define LOG_INFO \
-Logger(__FILE__, __LINE__, __FUNCTION__, Logger::INFO).getStream()
-
-#define LOG_ERROR \
-Logger(__FILE__, __LINE__, __FUNCTION__, Logger::ERROR).getStream()
+extern Logger::LogLevel g_logLevel;
 
-#define LOG_DEBUG \
-Logger(__FILE__, __LINE__, __FUNCTION__, Logger::DEBUG).getStream()
-
-#define LOG_FATAL \
-Logger(__FILE__, __LINE__, __FUNCTION__, Logger::FATAL).getStream()
+inline Logger::LogLevel Logger::logLevel()
+{
+    return g_logLevel;
+}
+
+// 编译期的最低日志级别，低于该级别的LOG_*在编译时就是死代码，连同参数的求值一起被去掉
+// 0 DEBUG, 1 INFO, 2 ERROR, 3 FATAL，Release构建默认为2（见CMakeLists.txt）
+#ifndef MYMUDUO_MIN_LOG_LEVEL
+#define MYMUDUO_MIN_LOG_LEVEL 0
+#endif
+
+// 先比较级别再构造Logger，被过滤的日志不会格式化时间戳和文件名，<<右边的表达式也不会求值
+// 写成if-else的形式，避免宏后面用户自己的else与宏里的if错误匹配
+#define LOG_IMPL(level) \
+if (MYMUDUO_MIN_LOG_LEVEL > Logger::level || Logger::logLevel() > Logger::level) {} \
+else Logger(__FILE__, __LINE__, __FUNCTION__, Logger::level).getStream()
+
+#define LOG_DEBUG LOG_IMPL(DEBUG)
+#define LOG_INFO LOG_IMPL(INFO)
+#define LOG_ERROR LOG_IMPL(ERROR)
+#define LOG_FATAL LOG_IMPL(FATAL)
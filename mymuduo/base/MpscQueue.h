@@ -0,0 +1,135 @@
+#pragma once
+
+#include "noncopyable.h"
+
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+
+// 侵入式节点，放入MpscQueue的类型需要继承该结构
+struct MpscNode
+{
+    std::atomic<MpscNode *> next{nullptr};
+};
+
+/**
+ * @brief
+ * 无锁的多生产者单消费者队列（Dmitry Vyukov的侵入式MPSC队列）
+ * 生产者push只有一次原子exchange和一次store，不会互相阻塞；
+ * 队列本身不分配内存，节点由使用者提供
+ * 消费者的pop、consume、empty只能在同一个线程中调用
+ * 全局按exchange的先后顺序出队，同一个生产者push的节点保持FIFO
+ */
+template<typename T>
+class MpscQueue: noncopyable
+{
+public:
+    MpscQueue(): head_(&stub_), tail_(&stub_) {}
+
+    // 多个线程可以同时调用
+    void push(T *node)
+    {
+        pushNode(node);
+    }
+
+    // 取出一个节点，队列为空或者某个生产者还没有完成链接时返回nullptr
+    T *pop()
+    {
+        MpscNode *tail = tail_;
+        MpscNode *next = tail->next.load(std::memory_order_acquire);
+        if (tail == &stub_)
+        {
+            if (next == nullptr)
+            {
+                return nullptr;
+            }
+            tail_ = next;
+            tail = next;
+            next = next->next.load(std::memory_order_acquire);
+        }
+
+        if (next)
+        {
+            tail_ = next;
+            return static_cast<T *>(tail);
+        }
+
+        // tail是最后一个节点，但可能有生产者已经exchange了head_还未链接
+        if (tail != head_.load(std::memory_order_acquire))
+        {
+            return nullptr;
+        }
+
+        // 把stub重新放回队尾，这样才能取出最后一个节点
+        pushNode(&stub_);
+        next = tail->next.load(std::memory_order_acquire);
+        if (next)
+        {
+            tail_ = next;
+            return static_cast<T *>(tail);
+        }
+        return nullptr;
+    }
+
+    // 依次取出调用时已在队列中的节点并交给f处理，f执行期间新入队的节点留给下一次
+    // 最多处理maxCount个，剩下的节点仍在队列中，返回处理的节点个数
+    template<typename Func>
+    size_t consume(Func &&f, size_t maxCount = SIZE_MAX)
+    {
+        size_t n = 0;
+        MpscNode *last = head_.load(std::memory_order_acquire);
+        if (last == &stub_)
+        {
+            // stub在队尾，stub之前的节点就是调用时已在队列中的节点
+            while (tail_ != &stub_ && n < maxCount)
+            {
+                T *node = pop();
+                if (node == nullptr)
+                {
+                    break;
+                }
+                ++n;
+                f(node);
+            }
+            return n;
+        }
+
+        while (n < maxCount)
+        {
+            T *node = pop();
+            if (node == nullptr)
+            {
+                break;
+            }
+            ++n;
+            bool isLast = (node == last);
+            f(node);
+            if (isLast)
+            {
+                break;
+            }
+        }
+        return n;
+    }
+
+    // 队列中是否还有未取出的节点（包括尚未完成链接的）
+    bool empty() const
+    {
+        return tail_ == &stub_ && head_.load() == &stub_;
+    }
+
+private:
+    void pushNode(MpscNode *node)
+    {
+        node->next.store(nullptr, std::memory_order_relaxed);
+        // exchange使用seq_cst，和EventLoop中的唤醒标志构成全序
+        MpscNode *prev = head_.exchange(node);
+        prev->next.store(node, std::memory_order_release);
+    }
+
+private:
+    // 生产者和消费者修改的成员放在不同的cache line，避免伪共享
+    alignas(64) std::atomic<MpscNode *> head_;  // 最后入队的节点
+    alignas(64) MpscNode *tail_;                // 下一个出队的节点
+    MpscNode stub_;
+};
@@ -3,16 +3,31 @@
 
 Timestamp::Timestamp(): microSecondsSinceEpoch_(0) {}
 Timestamp::Timestamp(int64_t microSecondsSinceEpoch): microSecondsSinceEpoch_(microSecondsSinceEpoch) {}
+
+static int64_t clockMicroSeconds(clockid_t clockId)
+{
+    struct timespec ts;
+    ::clock_gettime(clockId, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * Timestamp::kMicroSecondsPerSecond + ts.tv_nsec / 1000;
+}
+
 Timestamp Timestamp::now()
 {
-    return Timestamp(time(NULL));
+    return Timestamp(clockMicroSeconds(CLOCK_REALTIME));
 }
+
+Timestamp Timestamp::monotonicNow()
+{
+    return Timestamp(clockMicroSeconds(CLOCK_MONOTONIC));
+}
+
 std::string Timestamp::toString() const
 {
     char buf[128] = {0};
-    tm *tm_time = localtime(&microSecondsSinceEpoch_);
-    snprintf(buf, 128, "%4d%02d%02d-%02d:%02d:%02d", 
+    time_t seconds = static_cast<time_t>(microSecondsSinceEpoch_ / kMicroSecondsPerSecond);
+    tm *tm_time = localtime(&seconds);
+    snprintf(buf, 128, "%4d%02d%02d-%02d:%02d:%02d",
             tm_time->tm_year + 1900, tm_time->tm_mon + 1, tm_time->tm_mday,
             tm_time->tm_hour, tm_time->tm_min, tm_time->tm_sec);
     return buf;
-}
\ No newline at end of file
+}
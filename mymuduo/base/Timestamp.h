@@ -5,11 +5,50 @@
 class Timestamp
 {
 public:
+    static const int kMicroSecondsPerSecond = 1000 * 1000;
+
     Timestamp();
     explicit Timestamp(int64_t microSecondsSinceEpoch);
+    // 墙上时间，微秒精度
     static Timestamp now();
+    // 单调时间，微秒精度，不受系统时间调整的影响，定时器使用该时间
+    static Timestamp monotonicNow();
+    static Timestamp invalid() { return Timestamp(); }
+
     std::string toString() const;
 
+    bool valid() const { return microSecondsSinceEpoch_ > 0; }
+    int64_t microSecondsSinceEpoch() const { return microSecondsSinceEpoch_; }
+
 private:
-    int64_t microSecondsSinceEpoch_;    
-};
\ No newline at end of file
+    int64_t microSecondsSinceEpoch_;
+};
+
+inline bool operator<(Timestamp lhs, Timestamp rhs)
+{
+    return lhs.microSecondsSinceEpoch() < rhs.microSecondsSinceEpoch();
+}
+
+inline bool operator<=(Timestamp lhs, Timestamp rhs)
+{
+    return lhs.microSecondsSinceEpoch() <= rhs.microSecondsSinceEpoch();
+}
+
+inline bool operator==(Timestamp lhs, Timestamp rhs)
+{
+    return lhs.microSecondsSinceEpoch() == rhs.microSecondsSinceEpoch();
+}
+
+// 两个时间点的差值，单位秒
+inline double timeDifference(Timestamp high, Timestamp low)
+{
+    int64_t diff = high.microSecondsSinceEpoch() - low.microSecondsSinceEpoch();
+    return static_cast<double>(diff) / Timestamp::kMicroSecondsPerSecond;
+}
+
+// 在时间点上增加seconds秒
+inline Timestamp addTime(Timestamp timestamp, double seconds)
+{
+    int64_t delta = static_cast<int64_t>(seconds * Timestamp::kMicroSecondsPerSecond);
+    return Timestamp(timestamp.microSecondsSinceEpoch() + delta);
+}
@@ -0,0 +1,126 @@
+#include "../MpscQueue.h"
+#include "../Timestamp.h"
+
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <atomic>
+#include <stdio.h>
+#include <stdlib.h>
+
+// 对比EventLoop原先的 mutex + vector::swap 回调队列和无锁MPSC队列
+// 多个生产者线程不断投递回调，单个消费者线程循环取出并执行，统计总耗时
+
+using Functor = std::function<void()>;
+
+// 原先EventLoop::queueInLoop/doPendingFunctors的实现
+class MutexQueue
+{
+public:
+    void push(Functor cb)
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        pending_.emplace_back(std::move(cb));
+    }
+
+    size_t consume()
+    {
+        std::vector<Functor> functors;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            functors.swap(pending_);
+        }
+        for (const Functor &functor: functors)
+        {
+            functor();
+        }
+        return functors.size();
+    }
+
+private:
+    std::mutex mutex_;
+    std::vector<Functor> pending_;
+};
+
+struct Node: MpscNode
+{
+    explicit Node(Functor cb): functor(std::move(cb)) {}
+    Functor functor;
+};
+
+class LockFreeQueue
+{
+public:
+    void push(Functor cb)
+    {
+        queue_.push(new Node(std::move(cb)));
+    }
+
+    size_t consume()
+    {
+        return queue_.consume([](Node *node)
+        {
+            node->functor();
+            delete node;
+        });
+    }
+
+private:
+    MpscQueue<Node> queue_;
+};
+
+template<typename Queue>
+double bench(int numProducers, int perProducer)
+{
+    Queue queue;
+    std::atomic<int64_t> sum(0);
+    const int64_t total = static_cast<int64_t>(numProducers) * perProducer;
+
+    Timestamp start(Timestamp::monotonicNow());
+    std::vector<std::thread> producers;
+    for (int p = 0; p < numProducers; p++)
+    {
+        producers.emplace_back([&queue, &sum, perProducer]()
+        {
+            for (int i = 0; i < perProducer; i++)
+            {
+                queue.push([&sum]() { sum.fetch_add(1, std::memory_order_relaxed); });
+            }
+        });
+    }
+
+    int64_t consumed = 0;
+    while (consumed < total)
+    {
+        consumed += static_cast<int64_t>(queue.consume());
+    }
+
+    for (std::thread &t: producers)
+    {
+        t.join();
+    }
+    double seconds = timeDifference(Timestamp::monotonicNow(), start);
+    if (sum.load() != total)
+    {
+        printf("lost functors: %ld != %ld\n", sum.load(), total);
+        exit(1);
+    }
+    return seconds;
+}
+
+int main(int argc, char *argv[])
+{
+    int perProducer = argc > 1 ? atoi(argv[1]) : 1000000;
+    const int producerCounts[] = {1, 2, 4, 8};
+
+    printf("%-10s %16s %16s %10s\n", "producers", "mutex(Mops/s)", "mpsc(Mops/s)", "speedup");
+    for (int numProducers: producerCounts)
+    {
+        double total = static_cast<double>(numProducers) * perProducer / 1e6;
+        double mutexSec = bench<MutexQueue>(numProducers, perProducer);
+        double mpscSec = bench<LockFreeQueue>(numProducers, perProducer);
+        printf("%-10d %16.2f %16.2f %9.2fx\n", numProducers,
+                total / mutexSec, total / mpscSec, mutexSec / mpscSec);
+    }
+}
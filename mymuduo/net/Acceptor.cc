@@ -1,9 +1,11 @@
 #include "Acceptor.h"
 #include "Logger.h"
 #include "InetAddress.h"
+#include "EventLoop.h"
 #include <sys/socket.h>
 #include <sys/types.h>
 #include <errno.h>
+#include <fcntl.h>
 #include <unistd.h>
 
 static int createNonblocking()
@@ -18,58 +20,128 @@ static int createNonblocking()
     return sockfd;
 }
 
+// 没有fd可以用来丢弃连接时，暂停accept的时长
+static const double kAcceptPauseSeconds = 0.1;
+
 Acceptor::Acceptor(EventLoop *loop, const InetAddress &listenAddr, bool reuseport)
         : loop_(loop)
         , acceptSocket_(createNonblocking())
         , acceptChannel_(loop, acceptSocket_.fd())
         , listenning_(false)
+        , backlog_(Socket::kDefaultBacklog)
+        , maxAcceptsPerWakeup_(kDefaultMaxAcceptsPerWakeup)
+        , idleFd_(::open("/dev/null", O_RDONLY | O_CLOEXEC))
+        , paused_(false)
 {
     acceptSocket_.setReuseAddr(true);
-    acceptSocket_.setReusePort(true);
+    acceptSocket_.setReusePort(reuseport);
     acceptSocket_.bindAddress(listenAddr);
     acceptChannel_.setReadCallback(std::bind(&Acceptor::handleRead, this));
 }
 
 Acceptor::~Acceptor()
 {
+    if (paused_)
+    {
+        loop_->cancel(resumeTimer_);
+    }
     acceptChannel_.disableAll();
     acceptChannel_.remove();
+    if (idleFd_ >= 0)
+    {
+        ::close(idleFd_);
+    }
 }
 
 void Acceptor::listen()
 {
     listenning_ = true;
-    acceptSocket_.listen();
+    acceptSocket_.listen(backlog_);
     acceptChannel_.enableReading(); // acceptChannel_ => Poller
 }
 
 // listenfd有事件发生，即有新用户连接
+// 一次接受多个连接直到EAGAIN或达到maxAcceptsPerWakeup_，监听socket是水平触发的，剩余的连接下一轮继续
 void Acceptor::handleRead()
 {
-    InetAddress peerAddr;
-    int connfd = acceptSocket_.accept(peerAddr);
-    if (connfd >= 0)
+    for (int i = 0; i < maxAcceptsPerWakeup_; i++)
     {
-        if (newConnectionCallback_)
+        InetAddress peerAddr;
+        int connfd = acceptSocket_.accept(peerAddr);
+        if (connfd >= 0)
         {
-            // 轮询找到subLoop，唤醒并分发当前的新客户端的Channel
-            newConnectionCallback_(connfd, peerAddr);
+            if (newConnectionCallback_)
+            {
+                // 轮询找到subLoop，唤醒并分发当前的新客户端的Channel
+                newConnectionCallback_(connfd, peerAddr);
+            }
+            else
+            {
+                ::close(connfd);
+            }
+            continue;
         }
-        else
+
+        int savedErrno = errno;
+        switch (savedErrno)
         {
-            ::close(connfd);
+        case EAGAIN:
+            return;
+        case EINTR:
+        case ECONNABORTED:  // 对端在accept之前关闭了连接
+        case EPROTO:
+            break;
+        case EMFILE:
+        case ENFILE:
+            if (!shedConnection())
+            {
+                return;
+            }
+            break;
+        default:
+            LOG_ERROR << __FILE__ << ":" << __FUNCTION__ << ":" << __LINE__ 
+                    << " accept err: " << savedErrno;
+            return;
         }
     }
-    else
+}
+
+bool Acceptor::shedConnection()
+{
+    LOG_ERROR << __FILE__ << ":" << __FUNCTION__ << ":" << __LINE__ 
+            << " sockfd reached limit, shedding a connection, listenfd: " << acceptSocket_.fd();
+    bool shed = false;
+    if (idleFd_ >= 0)
     {
-        // LOG_ERROR("%s:%s:%d accept err: %d\n", __FILE__, __FUNCTION__, __LINE__, errno);
-        LOG_ERROR << __FILE__ << ":" << __FUNCTION__ << ":" << __LINE__ 
-                << " accept err: " << errno;
-        if (errno == EMFILE)
+        ::close(idleFd_);
+        int connfd = ::accept(acceptSocket_.fd(), nullptr, nullptr);
+        if (connfd >= 0)
         {
-            // LOG_ERROR("%s:%s:%d sockfd reached limit err: %d\n", __FILE__, __FUNCTION__, __LINE__, errno);
-            LOG_ERROR << __FILE__ << ":" << __FUNCTION__ << ":" << __LINE__ 
-                << " sockfd reached limit err: " << errno;
+            ::close(connfd);
+            shed = true;
         }
     }
-}
\ No newline at end of file
+    idleFd_ = ::open("/dev/null", O_RDONLY | O_CLOEXEC);
+    if (!shed)
+    {
+        // 预留fd也没有了（或被其他线程抢先占用），连接留在内核队列中，
+        // 监听socket是水平触发的，继续关注可读会一直空转，暂停一段时间再试
+        pauseAccepting();
+    }
+    return shed;
+}
+
+void Acceptor::pauseAccepting()
+{
+    if (paused_)
+    {
+        return;
+    }
+    paused_ = true;
+    acceptChannel_.disableReading();
+    resumeTimer_ = loop_->runAfter(kAcceptPauseSeconds, [this]()
+    {
+        paused_ = false;
+        acceptChannel_.enableReading();
+    });
+}
@@ -3,6 +3,7 @@
 #include "noncopyable.h"
 #include "Socket.h"
 #include "Channel.h"
+#include "TimerId.h"
 
 class EventLoop;
 class InetAddress;
@@ -22,13 +23,32 @@ public:
     bool listenning() const { return listenning_; }
     void listen();
 
+    // listen的backlog，需要在listen之前设置
+    void setBacklog(int backlog) { backlog_ = backlog; }
+    // 每次可读事件最多accept的连接数，剩余的连接留到下一轮poll，避免连接风暴时独占loop
+    void setMaxAcceptsPerWakeup(int count) { maxAcceptsPerWakeup_ = count > 0 ? count : 1; }
+    // 见Socket::setReusePortCpuSteering，需要在同一组的所有socket都listen之后调用
+    bool setReusePortCpuSteering(int numSockets) { return acceptSocket_.setReusePortCpuSteering(numSockets); }
+
+    static const int kDefaultMaxAcceptsPerWakeup = 64;
+
 private:
     void handleRead();
+    // 文件描述符耗尽时，用预留的fd接受并立即关闭一个连接，否则水平触发的监听socket会一直可读
+    // 没有预留fd可用时暂停accept并返回false
+    bool shedConnection();
+    // 取消关注监听socket的可读事件，kAcceptPauseSeconds之后恢复
+    void pauseAccepting();
     
 private:
-    EventLoop *loop_;   // Acceptor用的就是用户定义的baseLoop，也称作mainLoop
+    EventLoop *loop_;   // 一般是用户定义的baseLoop，也称作mainLoop；TcpServer的kReusePort模式下是subloop
     Socket acceptSocket_;
     Channel acceptChannel_;
     NewConnectionCallback newConnectionCallback_;
     bool listenning_;
+    int backlog_;
+    int maxAcceptsPerWakeup_;
+    int idleFd_;        // 预留的空闲fd，打开/dev/null
+    bool paused_;       // 是否因为fd耗尽暂停了accept
+    TimerId resumeTimer_;
 };
\ No newline at end of file
@@ -0,0 +1,103 @@
+#include "BlockPool.h"
+#include "CurrentThread.h"
+
+#include <new>
+
+BlockPool::BlockPool(pid_t ownerTid)
+        : ownerTid_(ownerTid)
+        , hits_(0)
+        , misses_(0)
+        , remoteFrees_(0)
+{
+}
+
+BlockPool::~BlockPool()
+{
+    for (SizeClass &sizeClass: classes_)
+    {
+        freeList(sizeClass.local);
+        freeList(sizeClass.remote.exchange(nullptr));
+    }
+}
+
+void BlockPool::freeList(void *block)
+{
+    while (block)
+    {
+        void *next = *static_cast<void **>(block);
+        ::operator delete(block);
+        block = next;
+    }
+}
+
+bool BlockPool::inOwnerThread() const
+{
+    return CurrentThread::tid() == ownerTid_;
+}
+
+void *BlockPool::allocate(size_t size)
+{
+    int index = sizeClassOf(size);
+    if (index < 0)
+    {
+        // 超过最大一档也计为未命中，否则对象长大到池外之后命中率看起来仍然正常
+        if (inOwnerThread())
+        {
+            misses_.store(misses_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        }
+        return ::operator new(size);
+    }
+
+    if (inOwnerThread())
+    {
+        SizeClass &sizeClass = classes_[index];
+        if (sizeClass.local == nullptr && sizeClass.remote.load(std::memory_order_relaxed))
+        {
+            // 本地链表用完了，取走其他线程释放的所有内存块
+            void *block = sizeClass.remote.exchange(nullptr, std::memory_order_acquire);
+            uint64_t n = 0;
+            for (void *p = block; p; p = *static_cast<void **>(p))
+            {
+                ++n;
+            }
+            remoteFrees_.fetch_add(n, std::memory_order_relaxed);
+            sizeClass.local = block;
+        }
+        if (sizeClass.local)
+        {
+            void *block = sizeClass.local;
+            sizeClass.local = *static_cast<void **>(block);
+            hits_.store(hits_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            return block;
+        }
+        misses_.store(misses_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+    // 按档位大小分配，之后可以放回这一档的链表复用
+    return ::operator new((index + 1) * kSizeClassBytes);
+}
+
+void BlockPool::deallocate(void *block, size_t size)
+{
+    int index = sizeClassOf(size);
+    if (index < 0)
+    {
+        ::operator delete(block);
+        return;
+    }
+
+    SizeClass &sizeClass = classes_[index];
+    if (inOwnerThread())
+    {
+        *static_cast<void **>(block) = sizeClass.local;
+        sizeClass.local = block;
+        return;
+    }
+
+    // 其他线程只压栈，所属线程只整体取走，不存在ABA问题
+    void *head = sizeClass.remote.load(std::memory_order_relaxed);
+    do
+    {
+        *static_cast<void **>(block) = head;
+    } while (!sizeClass.remote.compare_exchange_weak(head, block,
+            std::memory_order_release, std::memory_order_relaxed));
+}
@@ -0,0 +1,91 @@
+#pragma once
+#include <atomic>
+#include <memory>
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+#include "noncopyable.h"
+
+/**
+ * @brief
+ * 每个EventLoop一个的小块内存池，用于连接这类在loop线程中频繁创建和销毁的对象
+ * 按64字节一档分为kNumSizeClasses档，每档一个空闲链表，超过最大一档的请求直接使用operator new
+ * allocate只在所属loop线程中走空闲链表，其他线程调用时退回operator new（但按档位大小分配，可以回收）
+ * deallocate可以在任意线程调用：所属线程直接放回空闲链表，其他线程压入该档的远程栈，
+ * 所属线程的空闲链表用完时一次取走整个远程栈，和EventLoop回收回调节点的方式相同
+ * 回收的内存块不会归还系统，池的大小等于同时存在的对象数的峰值
+ */
+class BlockPool: noncopyable
+{
+public:
+    static const size_t kSizeClassBytes = 64;
+    static const int kNumSizeClasses = 16;  // 最大1024字节
+
+    explicit BlockPool(pid_t ownerTid);
+    ~BlockPool();
+
+    void *allocate(size_t size);
+    void deallocate(void *block, size_t size);
+
+    // 统计，可在任意线程读取
+    // 从空闲链表取得内存块的次数
+    uint64_t hits() const { return hits_.load(std::memory_order_relaxed); }
+    // 空闲链表为空或请求超过最大一档，调用operator new的次数
+    uint64_t misses() const { return misses_.load(std::memory_order_relaxed); }
+    // 由其他线程释放、经远程栈回收的内存块数
+    uint64_t remoteFrees() const { return remoteFrees_.load(std::memory_order_relaxed); }
+
+private:
+    struct SizeClass
+    {
+        void *local = nullptr;                      // 只由所属线程访问
+        alignas(64) std::atomic<void *> remote{nullptr};
+    };
+
+    // 不由池管理的大小返回-1
+    static int sizeClassOf(size_t size)
+    {
+        return size > 0 && size <= kSizeClassBytes * kNumSizeClasses
+                ? static_cast<int>((size - 1) / kSizeClassBytes) : -1;
+    }
+    bool inOwnerThread() const;
+    static void freeList(void *block);
+
+private:
+    const pid_t ownerTid_;
+    SizeClass classes_[kNumSizeClasses];
+    // hits_、misses_只在所属线程写入
+    std::atomic<uint64_t> hits_;
+    std::atomic<uint64_t> misses_;
+    std::atomic<uint64_t> remoteFrees_;
+};
+
+/**
+ * @brief
+ * 从BlockPool分配内存的标准库分配器，配合std::allocate_shared使用时，
+ * 对象和shared_ptr的控制块在同一个内存块中，都由池分配
+ * 分配器持有池的shared_ptr，对象比EventLoop活得久时池也不会提前释放
+ */
+template<typename T>
+class PoolAllocator
+{
+public:
+    using value_type = T;
+
+    explicit PoolAllocator(std::shared_ptr<BlockPool> pool): pool_(std::move(pool)) {}
+    template<typename U>
+    PoolAllocator(const PoolAllocator<U> &other): pool_(other.pool()) {}
+
+    T *allocate(size_t n) { return static_cast<T *>(pool_->allocate(n * sizeof(T))); }
+    void deallocate(T *p, size_t n) { pool_->deallocate(p, n * sizeof(T)); }
+
+    const std::shared_ptr<BlockPool> &pool() const { return pool_; }
+
+    template<typename U>
+    bool operator==(const PoolAllocator<U> &rhs) const { return pool_ == rhs.pool(); }
+    template<typename U>
+    bool operator!=(const PoolAllocator<U> &rhs) const { return pool_ != rhs.pool(); }
+
+private:
+    std::shared_ptr<BlockPool> pool_;
+};
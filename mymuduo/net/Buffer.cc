@@ -5,18 +5,18 @@
 
 const char Buffer::CRLF[] = "\r\n";
 
-ssize_t Buffer::readFd(int fd, int *saveErrno)
+ssize_t Buffer::readFd(int fd, int *saveErrno, size_t limit)
 {
-    char extrabuf[65536] = {0}; // 64K
+    char extrabuf[kExtraBufferSize]; // 64K
 
     struct iovec vec[2];
     const size_t writable = writableBytes();
     vec[0].iov_base = begin() + writerIndex_;
-    vec[0].iov_len = writable;
+    vec[0].iov_len = std::min(writable, limit);
     vec[1].iov_base = extrabuf;
-    vec[1].iov_len = sizeof(extrabuf);
+    vec[1].iov_len = std::min(sizeof(extrabuf), limit - vec[0].iov_len);
 
-    const int iovcnt = (writable < sizeof(extrabuf)) ? 2 : 1;
+    const int iovcnt = (writable < sizeof(extrabuf) && vec[1].iov_len > 0) ? 2 : 1;
     const ssize_t n = ::readv(fd, vec, iovcnt);
     if (n < 0)
     {
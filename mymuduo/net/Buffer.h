@@ -2,6 +2,7 @@
 #include <vector>
 #include <string>
 #include <algorithm>
+#include <stdint.h>
 
 /// +-------------------+------------------+------------------+
 /// | prependable bytes |  readable bytes  |  writable bytes  |
@@ -21,12 +22,21 @@ public:
     static const size_t kCheapPrepend = 8;
     // 初始writable的大小
     static const size_t kInitialSize = 1024;
+    // readFd使用的栈上额外缓冲区大小
+    static const size_t kExtraBufferSize = 65536;
 
     explicit Buffer(size_t initialSize = kInitialSize)
             : buffer_(kCheapPrepend + initialSize)
             , readerIndex_(kCheapPrepend)
             , writerIndex_(kCheapPrepend) {}
 
+    void swap(Buffer &rhs)
+    {
+        buffer_.swap(rhs.buffer_);
+        std::swap(readerIndex_, rhs.readerIndex_);
+        std::swap(writerIndex_, rhs.writerIndex_);
+    }
+
     // 可读的字节 
     size_t readableBytes() const
     {
@@ -132,7 +142,14 @@ public:
     }
 
     // read data directly into buffer
-    ssize_t readFd(int fd, int *saveErrno);
+    // 一次最多读取maxReadBytes()和limit中较小的字节数
+    ssize_t readFd(int fd, int *saveErrno, size_t limit = SIZE_MAX);
+    // 下一次readFd最多能读取的字节数，读到的字节数小于它说明内核接收缓冲区已经读空
+    size_t maxReadBytes() const
+    {
+        size_t writable = writableBytes();
+        return writable < kExtraBufferSize ? writable + kExtraBufferSize : writable;
+    }
     // 通过fd发送数据
     ssize_t writeFd(int fd, int *saveErrno);
 
@@ -0,0 +1,338 @@
+#include "ChainBuffer.h"
+#include <algorithm>
+#include <new>
+#include <errno.h>
+#include <limits.h>
+#include <string.h>
+#include <unistd.h>
+
+ChainBuffer::ChainBuffer(size_t blockSize)
+        : blockSize_(blockSize)
+        , head_(nullptr)
+        , tail_(nullptr)
+        , spare_(nullptr)
+        , readable_(0)
+        , blockCount_(0)
+{
+}
+
+ChainBuffer::~ChainBuffer()
+{
+    while (head_)
+    {
+        Block *next = head_->next;
+        freeBlock(head_);
+        head_ = next;
+    }
+    if (spare_)
+    {
+        freeBlock(spare_);
+    }
+}
+
+ChainBuffer::ChainBuffer(ChainBuffer &&rhs) noexcept
+        : blockSize_(rhs.blockSize_)
+        , head_(rhs.head_)
+        , tail_(rhs.tail_)
+        , spare_(rhs.spare_)
+        , readable_(rhs.readable_)
+        , blockCount_(rhs.blockCount_)
+{
+    rhs.head_ = rhs.tail_ = rhs.spare_ = nullptr;
+    rhs.readable_ = 0;
+    rhs.blockCount_ = 0;
+}
+
+ChainBuffer &ChainBuffer::operator=(ChainBuffer &&rhs) noexcept
+{
+    if (this != &rhs)
+    {
+        ChainBuffer tmp(std::move(rhs));
+        swap(tmp);
+    }
+    return *this;
+}
+
+void ChainBuffer::swap(ChainBuffer &rhs)
+{
+    std::swap(blockSize_, rhs.blockSize_);
+    std::swap(head_, rhs.head_);
+    std::swap(tail_, rhs.tail_);
+    std::swap(spare_, rhs.spare_);
+    std::swap(readable_, rhs.readable_);
+    std::swap(blockCount_, rhs.blockCount_);
+}
+
+ChainBuffer::Block *ChainBuffer::newBlock(size_t capacity)
+{
+    // 块头和数据在同一次分配中
+    Block *block = static_cast<Block *>(::operator new(sizeof(Block) + capacity));
+    block->next = nullptr;
+    block->capacity = capacity;
+    block->readerIndex = 0;
+    block->writerIndex = 0;
+    return block;
+}
+
+void ChainBuffer::freeBlock(Block *block)
+{
+    ::operator delete(block);
+}
+
+void ChainBuffer::recycleBlock(Block *block)
+{
+    if (spare_ == nullptr && block->capacity == blockSize_)
+    {
+        spare_ = block;
+    }
+    else
+    {
+        freeBlock(block);
+    }
+}
+
+void ChainBuffer::pushBlock()
+{
+    Block *block = spare_ ? spare_ : newBlock(blockSize_);
+    spare_ = nullptr;
+    block->next = nullptr;
+    block->readerIndex = 0;
+    block->writerIndex = 0;
+    if (tail_)
+    {
+        tail_->next = block;
+    }
+    else
+    {
+        head_ = block;
+    }
+    tail_ = block;
+    ++blockCount_;
+}
+
+void ChainBuffer::popHead()
+{
+    if (head_ == tail_)
+    {
+        head_->readerIndex = 0;
+        head_->writerIndex = 0;
+        return;
+    }
+    Block *block = head_;
+    head_ = block->next;
+    --blockCount_;
+    recycleBlock(block);
+}
+
+const char *ChainBuffer::peek() const
+{
+    return head_ ? head_->data() + head_->readerIndex : nullptr;
+}
+
+size_t ChainBuffer::firstBlockBytes() const
+{
+    return head_ ? head_->readableBytes() : 0;
+}
+
+const char *ChainBuffer::peekContiguous(size_t len)
+{
+    if (len <= firstBlockBytes())
+    {
+        return peek();
+    }
+
+    // 把前len个字节从各块中移出，拷贝到新的头块
+    Block *block = newBlock(std::max(len, blockSize_));
+    size_t copied = 0;
+    while (copied < len)
+    {
+        size_t n = std::min(len - copied, head_->readableBytes());
+        memcpy(block->data() + copied, head_->data() + head_->readerIndex, n);
+        head_->readerIndex += n;
+        copied += n;
+        if (head_->readableBytes() == 0)
+        {
+            Block *old = head_;
+            head_ = old->next;
+            if (head_ == nullptr)
+            {
+                tail_ = nullptr;
+            }
+            --blockCount_;
+            recycleBlock(old);
+        }
+    }
+    block->writerIndex = len;
+    block->next = head_;
+    head_ = block;
+    if (tail_ == nullptr)
+    {
+        tail_ = block;
+    }
+    ++blockCount_;
+    return block->data();
+}
+
+void ChainBuffer::retrieve(size_t len)
+{
+    len = std::min(len, readable_);
+    readable_ -= len;
+    while (len > 0)
+    {
+        size_t n = std::min(len, head_->readableBytes());
+        head_->readerIndex += n;
+        len -= n;
+        if (head_->readableBytes() == 0)
+        {
+            popHead();
+        }
+    }
+}
+
+void ChainBuffer::retrieveAll()
+{
+    if (head_ == tail_)
+    {
+        // 只有一块（或没有块）时直接复位，连接不积压时的常见情况
+        if (head_)
+        {
+            head_->readerIndex = 0;
+            head_->writerIndex = 0;
+        }
+        readable_ = 0;
+        return;
+    }
+    retrieve(readable_);
+}
+
+std::string ChainBuffer::retrieveAsString(size_t len)
+{
+    len = std::min(len, readable_);
+    std::string result;
+    result.reserve(len);
+    for (Block *block = head_; result.size() < len; block = block->next)
+    {
+        size_t n = std::min(len - result.size(), block->readableBytes());
+        result.append(block->data() + block->readerIndex, n);
+    }
+    retrieve(len);
+    return result;
+}
+
+void ChainBuffer::append(const char *data, size_t len)
+{
+    while (len > 0)
+    {
+        if (tail_ == nullptr || tail_->writableBytes() == 0)
+        {
+            pushBlock();
+        }
+        size_t n = std::min(len, tail_->writableBytes());
+        memcpy(tail_->data() + tail_->writerIndex, data, n);
+        tail_->writerIndex += n;
+        readable_ += n;
+        data += n;
+        len -= n;
+    }
+}
+
+int ChainBuffer::fillIovec(struct iovec *iov, int maxIov, size_t maxBytes) const
+{
+    int count = 0;
+    size_t bytes = 0;
+    for (Block *block = head_; block && count < maxIov && bytes < maxBytes; block = block->next)
+    {
+        size_t readable = block->readableBytes();
+        if (readable == 0)
+        {
+            continue;   // 全部读完时保留的空块
+        }
+        iov[count].iov_base = block->data() + block->readerIndex;
+        iov[count].iov_len = readable;
+        bytes += readable;
+        ++count;
+    }
+    return count;
+}
+
+size_t ChainBuffer::maxReadBytes() const
+{
+    size_t tailWritable = tail_ ? tail_->writableBytes() : 0;
+    return tailWritable + blockSize_ + kExtraBufferSize;
+}
+
+ssize_t ChainBuffer::readFd(int fd, int *saveErrno, size_t limit)
+{
+    char extrabuf[kExtraBufferSize];
+
+    struct iovec vec[3];
+    int iovcnt = 0;
+    size_t room = limit;
+    size_t tailLen = 0;
+    size_t spareLen = 0;
+    if (tail_ && tail_->writableBytes() > 0)
+    {
+        tailLen = std::min(tail_->writableBytes(), room);
+        vec[iovcnt].iov_base = tail_->data() + tail_->writerIndex;
+        vec[iovcnt++].iov_len = tailLen;
+        room -= tailLen;
+    }
+    if (room > 0)
+    {
+        // 数据多时直接读进一个新块，避免从栈上再拷贝一次
+        if (spare_ == nullptr)
+        {
+            spare_ = newBlock(blockSize_);
+        }
+        spareLen = std::min(blockSize_, room);
+        vec[iovcnt].iov_base = spare_->data();
+        vec[iovcnt++].iov_len = spareLen;
+        room -= spareLen;
+    }
+    if (room > 0)
+    {
+        vec[iovcnt].iov_base = extrabuf;
+        vec[iovcnt++].iov_len = std::min(sizeof(extrabuf), room);
+    }
+
+    const ssize_t n = ::readv(fd, vec, iovcnt);
+    if (n < 0)
+    {
+        *saveErrno = errno;
+        return n;
+    }
+
+    size_t left = n;
+    size_t inTail = std::min(left, tailLen);
+    if (inTail > 0)
+    {
+        tail_->writerIndex += inTail;
+        readable_ += inTail;
+        left -= inTail;
+    }
+    size_t inSpare = std::min(left, spareLen);
+    if (inSpare > 0)
+    {
+        pushBlock();    // 挂上备用块，数据已经在里面
+        tail_->writerIndex = inSpare;
+        readable_ += inSpare;
+        left -= inSpare;
+    }
+    if (left > 0)
+    {
+        append(extrabuf, left);
+    }
+    return n;
+}
+
+ssize_t ChainBuffer::writeFd(int fd, int *saveErrno) const
+{
+    struct iovec iov[IOV_MAX];
+    int iovcnt = fillIovec(iov, IOV_MAX);
+    ssize_t n = ::writev(fd, iov, iovcnt);
+    if (n < 0)
+    {
+        *saveErrno = errno;
+    }
+    return n;
+}
@@ -0,0 +1,95 @@
+#pragma once
+#include <string>
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+
+/**
+ * @brief
+ * 由固定大小的块串成的缓冲区，用于积压可能很大的发送缓冲区
+ * Buffer是一段连续内存，追加时空间不够要么resize（拷贝全部数据），要么把可读数据搬回头部，
+ * 积压到高水位（默认64M）时每次扩容都要拷贝几十MB；ChainBuffer追加时只在末尾挂新块，
+ * 已有数据从不移动，读完的块直接释放
+ * 块用单向链表串起来，空的ChainBuffer不分配任何内存；全部读完时保留最后一块复用
+ * +--------------------+    +--------------------+    +--------------------+
+ * | 已读 |    可读     | -> |       可读         | -> | 可读 |    可写     |
+ * +--------------------+    +--------------------+    +--------------------+
+ *  head_                                              tail_
+ * 不是线程安全的
+ */
+class ChainBuffer
+{
+public:
+    static const size_t kDefaultBlockSize = 4096;
+    // readFd使用的栈上额外缓冲区大小，与Buffer相同
+    static const size_t kExtraBufferSize = 65536;
+
+    explicit ChainBuffer(size_t blockSize = kDefaultBlockSize);
+    ~ChainBuffer();
+    ChainBuffer(ChainBuffer &&rhs) noexcept;
+    ChainBuffer &operator=(ChainBuffer &&rhs) noexcept;
+    ChainBuffer(const ChainBuffer &) = delete;
+    ChainBuffer &operator=(const ChainBuffer &) = delete;
+
+    void swap(ChainBuffer &rhs);
+
+    size_t readableBytes() const { return readable_; }
+    // 含有可读数据的块数，即fillIovec需要的iovec个数
+    int numBlocks() const { return readable_ > 0 ? blockCount_ : 0; }
+
+    // 第一块中的可读数据，只保证前firstBlockBytes()个字节连续
+    const char *peek() const;
+    size_t firstBlockBytes() const;
+    // 返回前len个可读字节的连续地址，供解析器使用
+    // 跨块时把这len个字节拷贝到一个新的头块中，其余数据不动；len不能超过readableBytes()
+    const char *peekContiguous(size_t len);
+
+    void retrieve(size_t len);
+    void retrieveAll();
+    std::string retrieveAsString(size_t len);
+    std::string retrieveAllAsString() { return retrieveAsString(readableBytes()); }
+
+    void append(const char *data, size_t len);
+    void append(const std::string &data) { append(data.data(), data.size()); }
+
+    // 按顺序把可读数据的各块填入iov，最多maxIov个，凑够maxBytes字节后停止，返回填入的个数
+    int fillIovec(struct iovec *iov, int maxIov, size_t maxBytes = SIZE_MAX) const;
+
+    // readv到末尾块的空闲空间、一个备用块和栈上的额外缓冲区，一次最多读取maxReadBytes()和limit中较小的字节数
+    ssize_t readFd(int fd, int *saveErrno, size_t limit = SIZE_MAX);
+    size_t maxReadBytes() const;
+    // 从头部的块writev，最多IOV_MAX块，不移除已发出的数据，与Buffer::writeFd相同
+    ssize_t writeFd(int fd, int *saveErrno) const;
+
+private:
+    struct Block
+    {
+        Block *next;
+        size_t capacity;
+        size_t readerIndex;
+        size_t writerIndex;
+
+        char *data() { return reinterpret_cast<char *>(this + 1); }
+        const char *data() const { return reinterpret_cast<const char *>(this + 1); }
+        size_t readableBytes() const { return writerIndex - readerIndex; }
+        size_t writableBytes() const { return capacity - writerIndex; }
+    };
+
+    static Block *newBlock(size_t capacity);
+    static void freeBlock(Block *block);
+    // 在末尾挂一个块，优先使用备用块
+    void pushBlock();
+    // 释放读空的头块，只剩一块时保留复用
+    void popHead();
+    // 不再使用的块：备用块为空时留作备用，否则释放
+    void recycleBlock(Block *block);
+
+private:
+    size_t blockSize_;
+    Block *head_;
+    Block *tail_;
+    Block *spare_;      // 备用块：readFd交给内核但没有用上的块，或最近读完的块
+    size_t readable_;
+    int blockCount_;    // 链表中的块数，全部读完时保留的一块也计入
+};
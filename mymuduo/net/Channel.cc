@@ -4,10 +4,12 @@
 #include "EventLoop.h"
 #include "../base/Logger.h"
 
-// 这里的事件都是LT模式，ET模式需要 | EPOLLET
+// 默认都是LT模式，setEdgeTriggered之后注册事件时 | EPOLLET
 const int Channel::kNoneEvent = 0;
 const int Channel::kReadEvent = EPOLLIN | EPOLLPRI;
 const int Channel::kWriteEvent = EPOLLOUT;
+const int Channel::kEdgeTriggered = EPOLLET;
+const int Channel::kPeerClosedEvent = EPOLLRDHUP;
 
 Channel::Channel(EventLoop *loop, int fd)
         : loop_(loop)
@@ -15,6 +17,7 @@ Channel::Channel(EventLoop *loop, int fd)
         , events_(0)
         , revents_(0)
         , index_(-1)
+        , edgeTriggered_(false)
         , tied_(false)
 {}
 
@@ -56,10 +59,28 @@ void Channel::handleEvent(Timestamp receiveTime)
     }
 }
 
+bool Channel::dropUnwatchedRevents()
+{
+    if (isNoneEvent())
+    {
+        revents_ = 0;
+        return false;
+    }
+    if (!isReading())
+    {
+        revents_ &= ~(EPOLLIN | EPOLLPRI | EPOLLRDHUP);
+    }
+    if (!isWriting())
+    {
+        revents_ &= ~EPOLLOUT;
+    }
+    return revents_ != 0;
+}
+
 // 根据poller通知的channel发生的具体事件，由channel负责调用具体的回调操作
 void Channel::handleEventWithGuard(Timestamp receiveTime)
 {
-    LOG_INFO << "channel handleEvent revents: "<< revents_;
+    LOG_DEBUG << "channel handleEvent revents: "<< revents_;
 
     if ((revents_ & EPOLLHUP) && !(revents_ & EPOLLIN))
     {
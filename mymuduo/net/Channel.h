@@ -3,6 +3,7 @@
 #include <memory>
 #include "noncopyable.h"
 #include "Timestamp.h"
+#include "InplaceFunction.h"
 
 class EventLoop;
 
@@ -14,8 +15,9 @@ class EventLoop;
 class Channel: noncopyable
 {
 public:
-    using EventCallback = std::function<void()>;
-    using ReadEventCallback = std::function<void(Timestamp)>;
+    // 回调对象内联存储在Channel中，设置回调时不分配内存
+    using EventCallback = InplaceFunction<void()>;
+    using ReadEventCallback = InplaceFunction<void(Timestamp)>;
 
     Channel(EventLoop *loop, int fd);
     ~Channel();
@@ -33,8 +35,23 @@ public:
     void tie(const std::shared_ptr<void>&);
 
     int fd() const { return fd_; }
-    int events() const { return events_; }
+    // 注册到poller的事件，边缘触发模式下附带EPOLLET，关注读时还附带EPOLLRDHUP
+    int events() const
+    {
+        if (!edgeTriggered_ || events_ == kNoneEvent)
+        {
+            return events_;
+        }
+        return events_ | kEdgeTriggered | ((events_ & kReadEvent) ? kPeerClosedEvent : 0);
+    }
+    int revents() const { return revents_; }
+    // 本次事件是否报告了对端关闭写端（EPOLLRDHUP，只在边缘触发时关注）
+    // 对端的数据和FIN一起到达时只有一次通知，读到的数据少于缓冲区也不能说明已经读完
+    bool peerClosedReported() const { return revents_ & kPeerClosedEvent; }
     void set_revents(int revt) { revents_ = revt; }
+    // 去掉revents中已经不再关注的事件，返回是否还有需要处理的事件
+    // 用于被推迟到下一轮处理的channel，期间它可能已经取消关注读写
+    bool dropUnwatchedRevents();
 
     // 设置fd相应的事件状态
     void enableReading() { events_ |= kReadEvent; update(); }
@@ -42,6 +59,13 @@ public:
     void enableWriting() { events_ |= kWriteEvent; update(); }
     void disableWriting() { events_ &= ~kWriteEvent; update(); }
     void disableAll() { events_ = kNoneEvent; update(); }
+    // 同时关注读写事件，只调用一次update
+    void enableAll() { events_ |= kReadEvent | kWriteEvent; update(); }
+
+    // 边缘触发模式，需要在注册事件之前设置，默认为水平触发
+    // 该模式下事件处理方必须把数据读写到EAGAIN
+    void setEdgeTriggered(bool on) { edgeTriggered_ = on; }
+    bool isEdgeTriggered() const { return edgeTriggered_; }
 
     // 返回fd当前的事件状态
     bool isNoneEvent() const { return events_ == kNoneEvent; }
@@ -63,6 +87,8 @@ private:
     static const int kNoneEvent;
     static const int kReadEvent;
     static const int kWriteEvent;
+    static const int kEdgeTriggered;
+    static const int kPeerClosedEvent;
 
     EventLoop *loop_;   // 事件循环
     const int fd_;      // fd, Poller监听的对象
@@ -70,6 +96,7 @@ private:
     int revents_;       // poller返回具体发生的事件
     int index_;         // 为Poller所用的状态表示，有三种值（New,Added,Delete）
                         // index这个名字或许不合适？？
+    bool edgeTriggered_;
 
     // 作用是什么？？
     std::weak_ptr<void> tie_;
@@ -1,15 +1,30 @@
 #include "Poller.h"
 #include "EPollPoller.h"
+#include "PollPoller.h"
+#include "UringPoller.h"
+#include "Logger.h"
 #include <stdlib.h>
 
 Poller *Poller::newDefaultPoller(EventLoop *loop)
 {
-    if (::getenv("MUDUO_USE_POLL"))
+    if (::getenv("MUDUO_USE_URING"))
     {
-        return nullptr;     // 生成poll的实例
+        // 生成io_uring的实例，内核不支持时回退到epoll
+        UringPoller *poller = new UringPoller(loop);
+        if (poller->valid())
+        {
+            return poller;
+        }
+        LOG_ERROR << "io_uring unavailable, fall back to epoll";
+        delete poller;
+        return new EPollPoller(loop);
+    }
+    else if (::getenv("MUDUO_USE_POLL"))
+    {
+        return new PollPoller(loop);    // 生成poll的实例
     }
     else
     {
         return new EPollPoller(loop);   // 生成epoll的实例
     }
-}
\ No newline at end of file
+}
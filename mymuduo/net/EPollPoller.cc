@@ -1,6 +1,7 @@
 #include "EPollPoller.h"
 #include "Logger.h"
 #include "Channel.h"
+#include "EventLoopStats.h"
 #include <errno.h>
 #include <unistd.h>
 #include <string.h>
@@ -16,6 +17,8 @@ EPollPoller::EPollPoller(EventLoop *loop)
         : Poller(loop)
         , epollfd_(::epoll_create1(EPOLL_CLOEXEC))
         , events_(kInitEventListSize)
+        , lazyIterations_(0)
+        , round_(0)
 {
     if (epollfd_ < 0)
     {
@@ -31,9 +34,14 @@ EPollPoller::~EPollPoller()
 // 封装了epoll_wait
 Timestamp EPollPoller::poll(int timeoutMs, ChannelList *activeChannels)
 {
-    // 实际应该用LOG_DEBUG
     // LOG_INFO("func = %s -> fd total count: %lu\n", __FUNCTION__, channels_.size());
-    LOG_INFO << "func = " << __FUNCTION__ << " -> fd total count: " << channels_.size();
+    LOG_DEBUG << "func = " << __FUNCTION__ << " -> fd total count: " << channels_.size();
+
+    ++round_;
+    if (!lazyDisarms_.empty())
+    {
+        expireLazyDisarms();
+    }
 
     int numEvents = ::epoll_wait(epollfd_, &*events_.begin(), static_cast<int>(events_.size()), timeoutMs);
     int saveErrno = errno;
@@ -42,7 +50,7 @@ Timestamp EPollPoller::poll(int timeoutMs, ChannelList *activeChannels)
     if (numEvents > 0)
     {
         // LOG_INFO("%d events happened\n", numEvents);
-        LOG_INFO << numEvents << " events happened";
+        LOG_DEBUG << numEvents << " events happened";
         fillActiveChannels(numEvents, activeChannels);
         if (numEvents == events_.size())
         {
@@ -70,7 +78,7 @@ void EPollPoller::updateChannel(Channel *channel)
 {
     const int index = channel->index();
     // LOG_INFO("func = %s -> fd = %d events = %d index = %d \n", __FUNCTION__, channel->fd(), channel->events(), index);
-    LOG_INFO << "func = " << __FUNCTION__ 
+    LOG_DEBUG << "func = " << __FUNCTION__ 
             << " -> fd = " << channel->fd() 
             << " events = " << channel->events()
             << " index = " << index;
@@ -81,7 +89,7 @@ void EPollPoller::updateChannel(Channel *channel)
         {
             // channel初始化时index就是kNew
             int fd = channel->fd();
-            channels_[fd] = channel;
+            channels_.insert(fd, channel);
         }
         channel->set_index(kAdded);
         update(EPOLL_CTL_ADD, channel);
@@ -94,11 +102,25 @@ void EPollPoller::updateChannel(Channel *channel)
             update(EPOLL_CTL_DEL, channel);
             // 标记为删除，但不在map中移除
             channel->set_index(kDelete);
+            return;
         }
-        else
+
+        uint32_t wanted = static_cast<uint32_t>(channel->events());
+        uint32_t &registered = *registered_.find(fd);
+        if (wanted == registered)
         {
-            update(EPOLL_CTL_MOD, channel);
+            // 包括延迟取消期间又重新关注写事件的情况
+            stats_->recordPollerCtlSkipped();
+            return;
         }
+        if (lazyIterations_ > 0 && (registered & ~wanted) == EPOLLOUT && (wanted & ~registered) == 0)
+        {
+            // 只是取消写事件，暂时保留内核中的EPOLLOUT
+            lazyDisarms_.push_back(LazyDisarm{fd, round_});
+            stats_->recordDeferredDisarm();
+            return;
+        }
+        update(EPOLL_CTL_MOD, channel);
     }
 }
 
@@ -109,7 +131,7 @@ void EPollPoller::removeChannel(Channel *channel)
     channels_.erase(fd);
 
     // LOG_INFO("func = %s -> fd = %d\n", __FUNCTION__, fd);
-    LOG_INFO << "func = " << __FUNCTION__
+    LOG_DEBUG << "func = " << __FUNCTION__
             << " -> fd = " << fd;
 
     int index = channel->index();
@@ -120,16 +142,50 @@ void EPollPoller::removeChannel(Channel *channel)
     channel->set_index(kNew);
 }
 
-void EPollPoller::fillActiveChannels(int numEvents, ChannelList *activeChannels) const
+void EPollPoller::fillActiveChannels(int numEvents, ChannelList *activeChannels)
 {
     for (int i = 0; i < numEvents; i++)
     {
         Channel *channel = static_cast<Channel*>(events_[i].data.ptr);
-        channel->set_revents(events_[i].events);
+        uint32_t revents = events_[i].events;
+        if ((revents & EPOLLOUT) && !channel->isWriting())
+        {
+            // 延迟取消的EPOLLOUT触发了，说明连接可写且没有数据要发，此时再取消
+            revents &= ~EPOLLOUT;
+            update(EPOLL_CTL_MOD, channel);
+            stats_->recordSpuriousEvent();
+            if (revents == 0)
+            {
+                continue;
+            }
+        }
+        channel->set_revents(revents);
         activeChannels->push_back(channel);
     }
 }
 
+void EPollPoller::expireLazyDisarms()
+{
+    size_t kept = 0;
+    for (const LazyDisarm &lazy: lazyDisarms_)
+    {
+        Channel **channel = channels_.find(lazy.fd);
+        uint32_t *registered = registered_.find(lazy.fd);
+        if (channel == nullptr || registered == nullptr
+                || *registered == static_cast<uint32_t>((*channel)->events()))
+        {
+            continue;   // 已经删除，或者已经重新关注写事件
+        }
+        if (round_ - lazy.round > lazyIterations_)
+        {
+            update(EPOLL_CTL_MOD, *channel);
+            continue;
+        }
+        lazyDisarms_[kept++] = lazy;
+    }
+    lazyDisarms_.resize(kept);
+}
+
 // 封装了epoll_ctl
 void EPollPoller::update(int operation, Channel *channel)
 {
@@ -141,6 +197,16 @@ void EPollPoller::update(int operation, Channel *channel)
     event.data.fd = fd;
     event.data.ptr = channel;
     
+    stats_->recordPollerCtl();
+    if (operation == EPOLL_CTL_DEL)
+    {
+        registered_.erase(fd);
+    }
+    else
+    {
+        registered_.insert(fd, event.events);
+    }
+
     if (::epoll_ctl(epollfd_, operation, fd, &event) < 0)
     {
         if (operation == EPOLL_CTL_DEL)
@@ -3,9 +3,17 @@
 #include <sys/epoll.h>
 #include "Poller.h"
 #include "Timestamp.h"
+#include "FdTable.h"
 
 class Channel;
 
+/**
+ * @brief
+ * 记录每个fd当前注册到内核的事件，关注的事件没有变化时不调用epoll_ctl
+ * 可选的延迟取消写事件：channel取消关注EPOLLOUT后暂时保留内核中的注册，
+ * 在之后的几轮poll中重新关注则一次epoll_ctl都不需要；
+ * 超过设定的轮数，或者保留的EPOLLOUT触发了（说明已经不需要），才真正MOD
+ */
 class EPollPoller: public Poller
 {
 public:
@@ -17,15 +25,31 @@ public:
     void updateChannel(Channel *channel) override;
     void removeChannel(Channel *channel) override;
 
+    void setLazyWriteDisarm(int iterations) override { lazyIterations_ = iterations; }
+
 private:
     // 填写活跃的连接
-    void fillActiveChannels(int numEvents, ChannelList *activeChannels) const;
+    void fillActiveChannels(int numEvents, ChannelList *activeChannels);
     // 更新channel通道
     void update(int operation, Channel *channel);
+    // 处理延迟取消写事件的channel，超过轮数的真正取消
+    void expireLazyDisarms();
 
 private:
+    // 延迟取消写事件的channel
+    struct LazyDisarm
+    {
+        int fd;
+        int64_t round;      // 开始延迟时的poll轮次
+    };
+
     static const int kInitEventListSize = 16;
     using EventList = std::vector<epoll_event>;
     int epollfd_;
     EventList events_;
+
+    FdTable<uint32_t> registered_;  // 每个fd当前注册在内核中的事件
+    int lazyIterations_;
+    int64_t round_;                 // poll轮次
+    std::vector<LazyDisarm> lazyDisarms_;
 };
\ No newline at end of file
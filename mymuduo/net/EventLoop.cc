@@ -2,14 +2,39 @@
 #include "Logger.h"
 #include "Poller.h"
 #include "Channel.h"
+#include "TimerQueue.h"
+#include "TimingWheel.h"
 #include <sys/eventfd.h>
 #include <unistd.h>
 #include <fcntl.h>
 #include <memory>
+#include <algorithm>
 
 // 防止一个线程创建多个EventLoop thread_local
 __thread EventLoop *t_loopInThisThread = nullptr;
 
+namespace
+{
+// 每个线程缓存的空闲回调节点，节点的第一个字保存下一个节点的地址
+// 线程退出时释放
+struct NodeCache
+{
+    void *head = nullptr;
+
+    ~NodeCache()
+    {
+        while (head)
+        {
+            void *next = *static_cast<void **>(head);
+            ::operator delete(head);
+            head = next;
+        }
+    }
+};
+
+thread_local NodeCache t_nodeCache;
+}
+
 // 定义默认的Poller IO复用接口的超时时间
 const int kPollTimeMs = 10000;
 
@@ -30,8 +55,20 @@ EventLoop::EventLoop()
         , callingPendingFunctors_(false)
         , threadId_(CurrentThread::tid())
         , poller_(Poller::newDefaultPoller(this))
+        , timerQueue_(new TimerQueue(this))
+        , blockPool_(std::make_shared<BlockPool>(CurrentThread::tid()))
         , wakeupFd_(createEventfd())
         , wakeupChannel_(new Channel(this, wakeupFd_))
+        , needWakeup_(false)
+        , busyPollUs_(0)
+        , iterationDeadline_(0)
+        , maxReadBytes_(kDefaultMaxReadBytes)
+        , maxFunctors_(0)
+        , maxIterationUs_(0)
+        , numConnections_(0)
+        , bulkBudgetCount_(kDefaultBulkBudgetCount)
+        , bulkBudgetUs_(kDefaultBulkBudgetUs)
+        , freeNodes_(nullptr)
         // , currentActiveChannel_(nullptr)
 {
     // LOG_DEBUG("EventLoop create %p in thread %d\n", this, threadId_);
@@ -57,6 +94,25 @@ EventLoop::~EventLoop()
     wakeupChannel_->disableAll();
     wakeupChannel_->remove();
     ::close(wakeupFd_);
+
+    // 释放没来得及执行的回调
+    while (PendingFunctor *node = pendingFunctors_.pop())
+    {
+        node->~PendingFunctor();
+        ::operator delete(node);
+    }
+    while (PendingFunctor *node = bulkFunctors_.pop())
+    {
+        node->~PendingFunctor();
+        ::operator delete(node);
+    }
+    void *block = freeNodes_.exchange(nullptr);
+    while (block)
+    {
+        void *next = *static_cast<void **>(block);
+        ::operator delete(block);
+        block = next;
+    }
     t_loopInThisThread = nullptr;
 }
 
@@ -75,14 +131,39 @@ void EventLoop::loop()
 
     while (!quit_)
     {
-        activeChannels_.clear();
-        // 监听两类fd，一种是client的fd，一种是wakeupFd
-        pollReturnTime_ = poller_->poll(kPollTimeMs, &activeChannels_);
-        for (Channel *channel: activeChannels_)
+        bool deferred = !deferredChannels_.empty();
+        int64_t iterationStart = 0;
+        if (deferred)
+        {
+            // 先处理上一轮推迟的channel，本轮不poll
+            activeChannels_.swap(deferredChannels_);
+            deferredChannels_.clear();
+            iterationStart = Timestamp::monotonicNow().microSecondsSinceEpoch();
+        }
+        else
+        {
+            activeChannels_.clear();
+            Timestamp pollStart(Timestamp::monotonicNow());
+            int64_t busyPollUs = busyPollUs_.load(std::memory_order_relaxed);
+            if (busyPollUs <= 0 || !busyPoll(busyPollUs))
+            {
+                // 先声明即将阻塞，再检查回调队列：生产者先入队再读needWakeup_，
+                // 两边都是seq_cst，要么生产者看到true并唤醒，要么这里看到队列非空而不阻塞
+                needWakeup_.store(true);
+                int timeoutMs = hasPendingFunctors() ? 0 : kPollTimeMs;
+                // 监听两类fd，一种是client的fd，一种是wakeupFd
+                pollReturnTime_ = poller_->poll(timeoutMs, &activeChannels_);
+                needWakeup_.store(false, std::memory_order_relaxed);
+            }
+            iterationStart = Timestamp::monotonicNow().microSecondsSinceEpoch();
+            stats_.recordPoll(iterationStart - pollStart.microSecondsSinceEpoch(), activeChannels_.size());
+        }
+
+        int64_t maxIterationUs = maxIterationUs_.load(std::memory_order_relaxed);
+        iterationDeadline_ = maxIterationUs > 0 ? iterationStart + maxIterationUs : 0;
+        if (!activeChannels_.empty())
         {
-            // Poller监听哪些channel发生了事件，上报给EventLoop，通知channel处理相应的事件
-            // channel会判断发生事件的类型（其实就是注册事件的类型，然后调用相应的回调函数）
-            channel->handleEvent(pollReturnTime_);
+            handleActiveChannels(deferred, iterationStart);
         }
         // 执行当前EventLoop事件循环需要处理的回调操作
         // mainLoop事先注册一个回调cb（需要subloop来执行）
@@ -95,6 +176,60 @@ void EventLoop::loop()
     looping_ = false;
 }
 
+void EventLoop::handleActiveChannels(bool deferred, int64_t startUs)
+{
+    const size_t numChannels = activeChannels_.size();
+    for (size_t i = 0; i < numChannels; i++)
+    {
+        Channel *channel = activeChannels_[i];
+        // 推迟期间channel可能已经取消关注某些事件
+        if (deferred && !channel->dropUnwatchedRevents())
+        {
+            continue;
+        }
+        // Poller监听哪些channel发生了事件，上报给EventLoop，通知channel处理相应的事件
+        // channel会判断发生事件的类型（其实就是注册事件的类型，然后调用相应的回调函数）
+        channel->handleEvent(pollReturnTime_);
+
+        // 每轮至少处理一个channel，保证推迟的channel总能被处理完
+        if (iterationDeadline_ > 0 && i + 1 < numChannels)
+        {
+            if (Timestamp::monotonicNow().microSecondsSinceEpoch() >= iterationDeadline_)
+            {
+                deferredChannels_.assign(activeChannels_.begin() + i + 1, activeChannels_.end());
+                stats_.recordDeferredChannels(deferredChannels_.size());
+                break;
+            }
+        }
+    }
+    stats_.recordCallbacks(Timestamp::monotonicNow().microSecondsSinceEpoch() - startUs);
+}
+
+bool EventLoop::busyPoll(int64_t budgetUs)
+{
+    Timestamp deadline(addTime(Timestamp::monotonicNow(),
+            static_cast<double>(budgetUs) / Timestamp::kMicroSecondsPerSecond));
+    do
+    {
+        // 自旋期间needWakeup_为false，其他线程投递的回调只能在这里发现
+        if (hasPendingFunctors() || quit_)
+        {
+            pollReturnTime_ = Timestamp::now();
+            stats_.recordBusyPoll(true);
+            return true;
+        }
+        pollReturnTime_ = poller_->poll(0, &activeChannels_);
+        if (!activeChannels_.empty())
+        {
+            stats_.recordBusyPoll(true);
+            return true;
+        }
+    } while (Timestamp::monotonicNow() < deadline);
+
+    stats_.recordBusyPoll(false);
+    return false;
+}
+
 // 退出事件循环
 // 1. loop在自己的线程中调用quit
 // 2. 在非loop线程中，调用loop的quit
@@ -117,25 +252,64 @@ void EventLoop::runInLoop(Functor cb)
     else
     {
         // 调用该函数runInLoop的线程和当前loop函数所在线程不一样，加入回调队列
-        queueInLoop(cb);
+        queueInLoop(std::move(cb));
     }
 }
 
-void EventLoop::queueInLoop(Functor cb)
+void EventLoop::queueInLoop(Functor cb, Priority priority)
 {
+    bool inLoopThread = isInLoopThread();
+    PendingFunctor *node = new (allocateNode()) PendingFunctor(std::move(cb), !inLoopThread);
+    if (priority == kBulk)
     {
-        std::unique_lock<std::mutex> lock(mutex_);
-        pendingFunctors_.emplace_back(cb);
+        bulkFunctors_.push(node);
+    }
+    else
+    {
+        pendingFunctors_.push(node);
     }
 
-    // 唤醒相应的，需要执行上面回调操作的loop线程
-    // callingPendingFunctors_表示当前loop正在执行回调，但是loop又有了新的回调
-    if (!isInLoopThread() || callingPendingFunctors_)
+    // loop线程自己投递的回调（包括正在执行回调时投递的）不需要唤醒，
+    // loop在下一次poll之前会检查队列
+    // 其他线程只在loop阻塞时唤醒，且每次阻塞只需要一个生产者写eventfd
+    if (!inLoopThread
+            && needWakeup_.load()
+            && needWakeup_.exchange(false))
     {
         wakeup();
     }
 }
 
+void *EventLoop::allocateNode()
+{
+    void *&cache = t_nodeCache.head;
+    if (cache == nullptr)
+    {
+        // 本线程的缓存用完了，取走本loop回收的所有节点
+        cache = freeNodes_.exchange(nullptr, std::memory_order_acquire);
+    }
+    if (cache)
+    {
+        void *block = cache;
+        cache = *static_cast<void **>(block);
+        return block;
+    }
+    return ::operator new(sizeof(PendingFunctor));
+}
+
+void EventLoop::recycleNode(PendingFunctor *node)
+{
+    node->~PendingFunctor();
+    void *block = node;
+    // 只有loop线程压栈，其他线程只会整体取走，不存在ABA问题
+    void *head = freeNodes_.load(std::memory_order_relaxed);
+    do
+    {
+        *static_cast<void **>(block) = head;
+    } while (!freeNodes_.compare_exchange_weak(head, block,
+            std::memory_order_release, std::memory_order_relaxed));
+}
+
 // 这里的读处理函数只处理wakeupfd的读事件，
 // 所以叫handleWakeup也许更合适？？
 void EventLoop::handleRead()
@@ -147,6 +321,11 @@ void EventLoop::handleRead()
         // LOG_ERROR("EventLoop::handleRead() reads %ld bytes instead of 8", n);
         LOG_ERROR << "EventLoop::handleRead() reads " << n << " bytes instead of 8";
     }
+    else
+    {
+        // eventfd读出的是上次读取以来所有write的累加值，即被唤醒的次数
+        stats_.recordWakeups(one);
+    }
 }
 
 // 向wakeupFd_写一个数据，wakeupChannel就发生读事件，当前loop线程就会被唤醒
@@ -161,6 +340,48 @@ void EventLoop::wakeup()
     }
 }
 
+TimerId EventLoop::runAt(Timestamp time, TimerCallback cb)
+{
+    // 墙上时间转换为单调时间，之后修改系统时间不会影响该定时器
+    double delay = timeDifference(time, Timestamp::now());
+    return runAfter(delay, std::move(cb));
+}
+
+TimerId EventLoop::runAfter(double delay, TimerCallback cb)
+{
+    Timestamp when(addTime(Timestamp::monotonicNow(), delay));
+    return timerQueue_->addTimer(std::move(cb), when, 0.0);
+}
+
+TimerId EventLoop::runEvery(double interval, TimerCallback cb)
+{
+    Timestamp when(addTime(Timestamp::monotonicNow(), interval));
+    return timerQueue_->addTimer(std::move(cb), when, interval);
+}
+
+void EventLoop::cancel(TimerId timerId)
+{
+    timerQueue_->cancel(timerId);
+}
+
+EventLoopStats::Snapshot EventLoop::stats() const
+{
+    EventLoopStats::Snapshot snap = stats_.snapshot();
+    snap.poolHits = blockPool_->hits();
+    snap.poolMisses = blockPool_->misses();
+    snap.poolRemoteFrees = blockPool_->remoteFrees();
+    return snap;
+}
+
+TimingWheel *EventLoop::timingWheel()
+{
+    if (!timingWheel_)
+    {
+        timingWheel_.reset(new TimingWheel(this));
+    }
+    return timingWheel_.get();
+}
+
 void EventLoop::updateChannel(Channel *channel)
 {
     poller_->updateChannel(channel);
@@ -168,6 +389,11 @@ void EventLoop::updateChannel(Channel *channel)
 
 void EventLoop::removeChannel(Channel *channel)
 {
+    if (!deferredChannels_.empty())
+    {
+        deferredChannels_.erase(std::remove(deferredChannels_.begin(), deferredChannels_.end(), channel),
+                deferredChannels_.end());
+    }
     poller_->removeChannel(channel);
 }
 
@@ -176,20 +402,97 @@ bool EventLoop::hasChannel(Channel *channel)
     return poller_->hasChannel(channel);
 }
 
+bool EventLoop::edgeTriggeredSupported() const
+{
+    return poller_->edgeTriggeredSupported();
+}
+
+void EventLoop::setLazyWriteDisarm(int iterations)
+{
+    runInLoop([this, iterations]()
+    {
+        poller_->setLazyWriteDisarm(iterations);
+    });
+}
+
+void EventLoop::setBulkBudget(size_t maxCount, int64_t maxMicroSeconds)
+{
+    bulkBudgetCount_.store(maxCount, std::memory_order_relaxed);
+    bulkBudgetUs_.store(maxMicroSeconds, std::memory_order_relaxed);
+}
+
 void EventLoop::doPendingFunctors()
 {
-    std::vector<Functor> functors;
     callingPendingFunctors_ = true;
 
+    // 只执行进入本函数时已经入队的回调，执行期间新加入的回调留到下一轮，
+    // 与原先swap出整个vector的语义一致
+    // 达到个数上限时剩下的回调留在队列中，下一次poll不会阻塞
+    Timestamp start(Timestamp::monotonicNow());
+    size_t maxCount = maxFunctors_.load(std::memory_order_relaxed);
+    size_t remote = 0;
+    size_t n = pendingFunctors_.consume([this, &remote](PendingFunctor *node)
+    {
+        remote += node->remote;
+        node->functor();    // 执行当前loop需要执行的回调操作
+        recycleNode(node);
+    }, maxCount > 0 ? maxCount : SIZE_MAX);
+    if (maxCount > 0 && n == maxCount && !pendingFunctors_.empty())
+    {
+        stats_.recordFunctorCarryOver();
+    }
+    if (n > 0)
     {
-        std::unique_lock<std::mutex> lock(mutex_);
-        functors.swap(pendingFunctors_);    // 将所有回调函数取出
+        stats_.recordFunctors(Timestamp::monotonicNow().microSecondsSinceEpoch()
+                - start.microSecondsSinceEpoch(), n, remote);
     }
 
-    for (const Functor &functor: functors)
+    if (!bulkFunctors_.empty())
     {
-        functor();  // 执行当前loop需要执行的回调操作
+        doBulkFunctors();
     }
 
     callingPendingFunctors_ = false;
+}
+
+// 紧急回调执行完之后再执行批量回调，用完预算就返回，剩下的由下一轮继续
+void EventLoop::doBulkFunctors()
+{
+    const size_t maxCount = bulkBudgetCount_.load(std::memory_order_relaxed);
+    const int64_t maxUs = bulkBudgetUs_.load(std::memory_order_relaxed);
+    Timestamp start(Timestamp::monotonicNow());
+    int64_t now = start.microSecondsSinceEpoch();
+    int64_t deadline = maxUs > 0 ? now + maxUs : 0;
+    // 本轮的时间上限同样约束批量回调
+    if (iterationDeadline_ > 0 && (deadline == 0 || iterationDeadline_ < deadline))
+    {
+        deadline = iterationDeadline_;
+    }
+
+    size_t n = 0;
+    size_t remote = 0;
+    while (maxCount == 0 || n < maxCount)
+    {
+        PendingFunctor *node = bulkFunctors_.pop();
+        if (node == nullptr)
+        {
+            break;
+        }
+        ++n;
+        remote += node->remote;
+        node->functor();
+        recycleNode(node);
+
+        now = Timestamp::monotonicNow().microSecondsSinceEpoch();
+        if (deadline > 0 && now >= deadline)
+        {
+            break;
+        }
+    }
+
+    if (n > 0)
+    {
+        stats_.recordFunctors(now - start.microSecondsSinceEpoch(), n, remote);
+    }
+    stats_.recordBulk(n, !bulkFunctors_.empty());
 }
\ No newline at end of file
@@ -3,19 +3,40 @@
 #include <vector>
 #include <atomic>
 #include <memory>
-#include <mutex>
 #include "noncopyable.h"
+#include "MpscQueue.h"
+#include "InplaceFunction.h"
 #include "Timestamp.h"
 #include "CurrentThread.h"
+#include "Callbacks.h"
+#include "TimerId.h"
+#include "EventLoopStats.h"
+#include "BlockPool.h"
 
 class Channel;
 class Poller;
+class TimerQueue;
+class TimingWheel;
 
 // 事件循环类，包含Channel和Poller（epoll的抽象）两个模块
 class EventLoop
 {
 public:
-    using Functor = std::function<void()>;
+    // 只能移动，不超过64字节的可调用对象（如bind一个成员函数和shared_ptr）不分配内存
+    using Functor = InplaceFunction<void()>;
+
+    // 回调的优先级
+    // kUrgent：每轮全部执行（可用setMaxFunctorsPerDrain限制），如connectEstablished、控制消息
+    // kBulk：每轮最多执行预算内的部分，剩下的留到下一轮，如广播、缓存预热等批量任务
+    enum Priority
+    {
+        kUrgent,
+        kBulk,
+    };
+
+    static const size_t kDefaultBulkBudgetCount = 1024;
+    static const int64_t kDefaultBulkBudgetUs = 1000;
+    static const size_t kDefaultMaxReadBytes = 256 * 1024;
 
     EventLoop();
     ~EventLoop();
@@ -30,45 +51,161 @@ public:
     // 在当前loop中执行cb
     void runInLoop(Functor cb);
     // 把cb放入队列中，唤醒loop所在线程，执行cb
-    void queueInLoop(Functor cb);
+    void queueInLoop(Functor cb, Priority priority = kUrgent);
+
+    // 每轮循环执行kBulk回调的上限，个数和时间（微秒）先到者为准，0表示不限制，线程安全
+    // 有剩余的批量回调时poll不阻塞，I/O事件和紧急回调在两批之间得到处理
+    void setBulkBudget(size_t maxCount, int64_t maxMicroSeconds);
+
+    // 每轮循环的公平性预算，线程安全，0表示不限制
+    // 每个连接每次读事件最多读取的字节数（默认256K），剩余的数据留到下一轮：
+    // 水平触发由下一次poll再次通知，边缘触发把继续读取放入回调队列
+    void setMaxReadBytesPerWakeup(size_t bytes) { maxReadBytes_.store(bytes, std::memory_order_relaxed); }
+    size_t maxReadBytesPerWakeup() const { return maxReadBytes_.load(std::memory_order_relaxed); }
+    // 每轮最多执行的kUrgent回调个数（默认不限制），剩下的留在队列中，下一次poll不阻塞
+    void setMaxFunctorsPerDrain(size_t maxCount) { maxFunctors_.store(maxCount, std::memory_order_relaxed); }
+    // 每轮处理活跃channel和kBulk回调的时间上限（微秒，默认不限制）
+    // 超时后本轮还没处理的channel推迟到下一轮，下一轮先处理它们再poll
+    void setMaxIterationTime(int64_t microSeconds) { maxIterationUs_.store(microSeconds, std::memory_order_relaxed); }
 
     // 用来唤醒loop所在线程
     void wakeup();
 
+    // 运行统计的快照，可在任意线程调用
+    EventLoopStats::Snapshot stats() const;
+    // 供Poller等loop内部模块写入统计，只能在loop所在线程使用
+    EventLoopStats *mutableStats() { return &stats_; }
+
+    // 唤醒统计，可在任意线程读取
+    // 实际写eventfd唤醒loop的次数
+    uint64_t wakeupCount() const { return stats_.wakeups(); }
+    // 其他线程投递回调时因loop未阻塞而省掉的eventfd写次数
+    uint64_t wakeupSavedCount() const
+    {
+        uint64_t remote = stats_.remoteFunctors();
+        uint64_t woken = wakeupCount();
+        return remote > woken ? remote - woken : 0;
+    }
+
+    // 分配到本loop的连接数，TcpServer分配连接时加1、移除连接时减1，可在任意线程调用
+    // 供EventLoopThreadPool按负载选择loop
+    int numConnections() const { return numConnections_.load(std::memory_order_relaxed); }
+    void adjustConnectionCount(int delta) { numConnections_.fetch_add(delta, std::memory_order_relaxed); }
+    // 处理事件和回调的累计时间（微秒），可在任意线程调用
+    uint64_t busyMicroSeconds() const { return stats_.busyUs(); }
+
+    // 忙轮询模式，线程安全，microSeconds为0表示关闭（默认）
+    // 开启后每轮先以0超时反复poll并检查回调队列，持续microSeconds微秒仍没有任务才阻塞等待，
+    // 用一个CPU核换取更低的延迟；自旋期间其他线程投递回调不需要写eventfd
+    void setBusyPollBudget(int64_t microSeconds) { busyPollUs_.store(microSeconds, std::memory_order_relaxed); }
+    int64_t busyPollBudget() const { return busyPollUs_.load(std::memory_order_relaxed); }
+    // 自旋期间拿到任务的轮数，以及自旋预算用完后阻塞等待的轮数，用来调整预算
+    uint64_t busyPollHits() const { return stats_.busyPollHits(); }
+    uint64_t blockingPolls() const { return stats_.blockingPolls(); }
+
+    // 定时器接口，均为线程安全，回调在loop所在线程执行
+    // 在墙上时间time执行cb
+    TimerId runAt(Timestamp time, TimerCallback cb);
+    // delay秒后执行cb
+    TimerId runAfter(double delay, TimerCallback cb);
+    // 每隔interval秒执行一次cb
+    TimerId runEvery(double interval, TimerCallback cb);
+    // 取消定时器
+    void cancel(TimerId timerId);
+
+    // 返回本loop的时间轮，第一次调用时创建，只能在loop所在线程调用
+    TimingWheel *timingWheel();
+    // 本loop的小块内存池，TcpServer用它分配连接对象，见BlockPool
+    const std::shared_ptr<BlockPool> &blockPool() const { return blockPool_; }
+
     // EventLoop的函数 -> Poller的函数
     void updateChannel(Channel *channel);
     void removeChannel(Channel *channel);
     bool hasChannel(Channel *channel);
+    // 当前使用的Poller是否支持边缘触发
+    bool edgeTriggeredSupported() const;
+    // channel取消关注写事件后，EPOLLOUT在内核中最多保留iterations轮poll再真正取消，0表示立即取消（默认）
+    // 连接持续有积压时，取消后很快又重新关注，延迟可以省掉成对的epoll_ctl(MOD)
+    // 保留期间EPOLLOUT一旦触发就立即取消，所以不会因此空转，轮数可以设得宽松一些
+    // 目前只有EPollPoller支持，线程安全
+    void setLazyWriteDisarm(int iterations);
 
     // 判断调用该函数的线程和loop循环所在线程是否一致
     bool isInLoopThread() const { return threadId_ == CurrentThread::tid(); }
 
 private:
+    struct PendingFunctor;
+
     // 处理wakeup
     void handleRead();
     // 执行回调
     void doPendingFunctors();
+    // 在预算内执行批量回调
+    void doBulkFunctors();
+    // 处理activeChannels_，超过本轮时间上限时把剩下的放入deferredChannels_
+    void handleActiveChannels(bool deferred, int64_t startUs);
+    // 两个回调队列中是否还有回调
+    bool hasPendingFunctors() const { return !pendingFunctors_.empty() || !bulkFunctors_.empty(); }
+    // 在预算时间内以0超时自旋poll，拿到事件或回调时返回true
+    bool busyPoll(int64_t budgetUs);
+    // 在任意线程调用，返回一块可以构造PendingFunctor的内存
+    void *allocateNode();
+    // 只在loop线程调用，析构节点并放回空闲节点栈
+    void recycleNode(PendingFunctor *node);
 
 private:
     using ChannelList = std::vector<Channel *>;
+
+    // 回调队列中的节点，由allocateNode从空闲节点中取得，执行后由recycleNode回收
+    struct PendingFunctor: MpscNode
+    {
+        PendingFunctor(Functor cb, bool fromOtherThread)
+                : functor(std::move(cb))
+                , remote(fromOtherThread) {}
+        Functor functor;
+        bool remote;    // 是否由其他线程投递，只用于统计
+    };
+
     std::atomic_bool looping_;                  // 原子操作，通过CAS实现
     std::atomic_bool quit_;                     // 标识退出loop循环
     
     const pid_t threadId_;                      // 记录当前loop所在线程id
 
     Timestamp pollReturnTime_;                  // poller返回发生事件的channels的时间点
+    EventLoopStats stats_;                      // 只由loop线程写入，Poller构造时就会用到，需要先于poller_初始化
     std::shared_ptr<Poller> poller_;
+    std::unique_ptr<TimerQueue> timerQueue_;
+    std::unique_ptr<TimingWheel> timingWheel_;  // 用于空闲连接淘汰，按需创建
+    std::shared_ptr<BlockPool> blockPool_;
 
     // 当mainloop获取一个新用户的channel，
     // 通过轮询算法选择一个subloop，通过该成员唤醒subloop处理
     // wakeupFd是一个eventfd
     int wakeupFd_;
     std::unique_ptr<Channel> wakeupChannel_;
+    // loop阻塞（或即将阻塞）在poll中时为true，只有此时其他线程才需要写eventfd，
+    // 第一个把它改为false的生产者负责唤醒，其余生产者直接返回
+    alignas(64) std::atomic_bool needWakeup_;
+    std::atomic<int64_t> busyPollUs_;       // 忙轮询预算，单位微秒
 
     ChannelList activeChannels_;
+    // 上一轮超时没来得及处理的channel，revents仍是当时poll的结果，
+    // 处理完之前不再poll，避免同一个事件被处理两次；removeChannel时从中删除
+    ChannelList deferredChannels_;
+    int64_t iterationDeadline_;             // 本轮的截止时间（单调时钟微秒），0表示不限制
+    std::atomic<size_t> maxReadBytes_;
+    std::atomic<size_t> maxFunctors_;
+    std::atomic<int64_t> maxIterationUs_;
+    std::atomic_int numConnections_;
     // Channel *currentActiveChannel_;
 
     std::atomic_bool callingPendingFunctors_;   // 标识当前loop是否有需要执行的回调操作
-    std::vector<Functor> pendingFunctors_;      // 存储loop需要执行的所有回调操作
-    std::mutex mutex_;                          // 互斥锁，用来保护上面vector容器的线程安全操作
+    // 存储loop需要执行的所有回调操作，无锁多生产者单消费者队列，生产者之间不争用锁
+    MpscQueue<PendingFunctor> pendingFunctors_;
+    MpscQueue<PendingFunctor> bulkFunctors_;    // kBulk优先级的回调
+    std::atomic<size_t> bulkBudgetCount_;
+    std::atomic<int64_t> bulkBudgetUs_;
+    // 执行完的节点，loop线程逐个压入，投递回调的线程本地缓存用完时一次取走整个栈，
+    // 稳定运行后投递回调不再调用malloc
+    alignas(64) std::atomic<void *> freeNodes_;
 };
\ No newline at end of file
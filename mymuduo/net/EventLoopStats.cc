@@ -0,0 +1,72 @@
+#include "EventLoopStats.h"
+
+EventLoopStats::Snapshot &EventLoopStats::Snapshot::operator+=(const Snapshot &rhs)
+{
+    iterations += rhs.iterations;
+    pollUs += rhs.pollUs;
+    callbackUs += rhs.callbackUs;
+    functorUs += rhs.functorUs;
+    functorDrains += rhs.functorDrains;
+    functors += rhs.functors;
+    if (rhs.maxFunctorsPerDrain > maxFunctorsPerDrain)
+    {
+        maxFunctorsPerDrain = rhs.maxFunctorsPerDrain;
+    }
+    remoteFunctors += rhs.remoteFunctors;
+    events += rhs.events;
+    for (int i = 0; i < kHistogramBuckets; i++)
+    {
+        eventsPerPoll[i] += rhs.eventsPerPoll[i];
+    }
+    wakeups += rhs.wakeups;
+    busyPollHits += rhs.busyPollHits;
+    blockingPolls += rhs.blockingPolls;
+    pollerCtls += rhs.pollerCtls;
+    pollerCtlsSkipped += rhs.pollerCtlsSkipped;
+    deferredDisarms += rhs.deferredDisarms;
+    spuriousEvents += rhs.spuriousEvents;
+    bulkFunctors += rhs.bulkFunctors;
+    bulkCarryOvers += rhs.bulkCarryOvers;
+    functorCarryOvers += rhs.functorCarryOvers;
+    deferredChannels += rhs.deferredChannels;
+    poolHits += rhs.poolHits;
+    poolMisses += rhs.poolMisses;
+    poolRemoteFrees += rhs.poolRemoteFrees;
+    zeroCopySends += rhs.zeroCopySends;
+    zeroCopyCompletions += rhs.zeroCopyCompletions;
+    zeroCopyCopied += rhs.zeroCopyCopied;
+    return *this;
+}
+
+EventLoopStats::Snapshot EventLoopStats::snapshot() const
+{
+    Snapshot snap;
+    snap.iterations = iterations_.load(std::memory_order_relaxed);
+    snap.pollUs = pollUs_.load(std::memory_order_relaxed);
+    snap.callbackUs = callbackUs_.load(std::memory_order_relaxed);
+    snap.functorUs = functorUs_.load(std::memory_order_relaxed);
+    snap.functorDrains = functorDrains_.load(std::memory_order_relaxed);
+    snap.functors = functors_.load(std::memory_order_relaxed);
+    snap.maxFunctorsPerDrain = maxFunctorsPerDrain_.load(std::memory_order_relaxed);
+    snap.remoteFunctors = remoteFunctors_.load(std::memory_order_relaxed);
+    snap.events = events_.load(std::memory_order_relaxed);
+    for (int i = 0; i < kHistogramBuckets; i++)
+    {
+        snap.eventsPerPoll[i] = eventsPerPoll_[i].load(std::memory_order_relaxed);
+    }
+    snap.wakeups = wakeups_.load(std::memory_order_relaxed);
+    snap.busyPollHits = busyPollHits_.load(std::memory_order_relaxed);
+    snap.blockingPolls = blockingPolls_.load(std::memory_order_relaxed);
+    snap.pollerCtls = pollerCtls_.load(std::memory_order_relaxed);
+    snap.pollerCtlsSkipped = pollerCtlsSkipped_.load(std::memory_order_relaxed);
+    snap.deferredDisarms = deferredDisarms_.load(std::memory_order_relaxed);
+    snap.spuriousEvents = spuriousEvents_.load(std::memory_order_relaxed);
+    snap.bulkFunctors = bulkFunctors_.load(std::memory_order_relaxed);
+    snap.bulkCarryOvers = bulkCarryOvers_.load(std::memory_order_relaxed);
+    snap.functorCarryOvers = functorCarryOvers_.load(std::memory_order_relaxed);
+    snap.deferredChannels = deferredChannels_.load(std::memory_order_relaxed);
+    snap.zeroCopySends = zeroCopySends_.load(std::memory_order_relaxed);
+    snap.zeroCopyCompletions = zeroCopyCompletions_.load(std::memory_order_relaxed);
+    snap.zeroCopyCopied = zeroCopyCopied_.load(std::memory_order_relaxed);
+    return snap;
+}
@@ -0,0 +1,180 @@
+#pragma once
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+#include "noncopyable.h"
+
+/**
+ * @brief
+ * EventLoop的运行统计，每个loop一个
+ * 计数器只由loop线程写入，单写者不需要原子的读-改-写，用relaxed的load+store累加，
+ * 写路径上没有锁前缀指令；其他线程通过snapshot()随时读取
+ * 各个字段分别读取，快照内部不保证严格一致，用于观察趋势足够了
+ */
+class EventLoopStats: noncopyable
+{
+public:
+    // 每次poll返回的事件数直方图，第0个桶是0个事件，第i个桶是[2^(i-1), 2^i)，最后一个桶不设上限
+    static const int kHistogramBuckets = 12;
+
+    struct Snapshot
+    {
+        uint64_t iterations = 0;        // 循环轮数
+        uint64_t pollUs = 0;            // 在poll中的时间（阻塞等待和忙轮询自旋）
+        uint64_t callbackUs = 0;        // 执行Channel::handleEvent的时间
+        uint64_t functorUs = 0;         // 执行doPendingFunctors的时间
+        uint64_t functorDrains = 0;     // 执行了至少一个回调的doPendingFunctors次数
+        uint64_t functors = 0;          // 执行的回调总数
+        uint64_t maxFunctorsPerDrain = 0;
+        uint64_t remoteFunctors = 0;    // 其他线程投递的回调个数
+        uint64_t events = 0;            // poll返回的事件总数
+        uint64_t eventsPerPoll[kHistogramBuckets] = {};
+        uint64_t wakeups = 0;           // eventfd被写入的次数
+        uint64_t busyPollHits = 0;      // 忙轮询期间拿到任务的轮数
+        uint64_t blockingPolls = 0;     // 忙轮询预算用完后阻塞等待的轮数
+        uint64_t pollerCtls = 0;        // 实际执行的epoll_ctl次数
+        uint64_t pollerCtlsSkipped = 0; // 关注的事件没有变化而省掉的epoll_ctl次数
+        uint64_t deferredDisarms = 0;   // 延迟取消EPOLLOUT的次数
+        uint64_t spuriousEvents = 0;    // 延迟期间EPOLLOUT触发但channel已不再关注的次数
+        uint64_t bulkFunctors = 0;      // 执行的kBulk回调个数（也计入functors）
+        uint64_t bulkCarryOvers = 0;    // 预算用完时仍有kBulk回调、留到下一轮的次数
+        uint64_t functorCarryOvers = 0; // kUrgent回调达到每轮个数上限、留到下一轮的次数
+        uint64_t deferredChannels = 0;  // 超过每轮时间上限、推迟到下一轮处理的活跃channel数
+        uint64_t poolHits = 0;          // BlockPool从空闲链表分配的次数，见EventLoop::blockPool
+        uint64_t poolMisses = 0;        // BlockPool调用operator new的次数
+        uint64_t poolRemoteFrees = 0;   // 由其他线程释放、回收到BlockPool的内存块数
+        uint64_t zeroCopySends = 0;     // 带MSG_ZEROCOPY发出的send次数，见TcpConnection::setZeroCopyThreshold
+        uint64_t zeroCopyCompletions = 0;   // 内核通知已完成的零拷贝send次数
+        uint64_t zeroCopyCopied = 0;    // 其中内核实际做了拷贝的次数（例如loopback）
+
+        // 聚合多个loop，max字段取最大值，其余字段相加
+        Snapshot &operator+=(const Snapshot &rhs);
+
+        // 平均每次drain执行的回调数
+        double functorsPerDrain() const
+        {
+            return functorDrains > 0 ? static_cast<double>(functors) / functorDrains : 0.0;
+        }
+        // BlockPool的命中率
+        double poolHitRatio() const
+        {
+            uint64_t total = poolHits + poolMisses;
+            return total > 0 ? static_cast<double>(poolHits) / total : 0.0;
+        }
+        // 处理事件和回调的时间占比，接近1说明loop已经饱和
+        double busyRatio() const
+        {
+            uint64_t work = callbackUs + functorUs;
+            uint64_t total = work + pollUs;
+            return total > 0 ? static_cast<double>(work) / total : 0.0;
+        }
+        // 直方图第i个桶的下界
+        static uint64_t bucketLowerBound(int i) { return i == 0 ? 0 : 1ULL << (i - 1); }
+    };
+
+    EventLoopStats() = default;
+
+    // 以下只能在loop线程调用
+    void recordPoll(int64_t us, size_t numEvents)
+    {
+        add(iterations_, 1);
+        add(pollUs_, us);
+        add(events_, numEvents);
+        add(eventsPerPoll_[bucketOf(numEvents)], 1);
+    }
+    void recordCallbacks(int64_t us) { add(callbackUs_, us); }
+    void recordFunctors(int64_t us, size_t n, size_t remote)
+    {
+        add(functorUs_, us);
+        add(functorDrains_, 1);
+        add(functors_, n);
+        add(remoteFunctors_, remote);
+        if (n > maxFunctorsPerDrain_.load(std::memory_order_relaxed))
+        {
+            maxFunctorsPerDrain_.store(n, std::memory_order_relaxed);
+        }
+    }
+    void recordWakeups(uint64_t n) { add(wakeups_, n); }
+    void recordBusyPoll(bool hit) { add(hit ? busyPollHits_ : blockingPolls_, 1); }
+    void recordPollerCtl() { add(pollerCtls_, 1); }
+    void recordPollerCtlSkipped() { add(pollerCtlsSkipped_, 1); }
+    void recordDeferredDisarm() { add(deferredDisarms_, 1); }
+    void recordSpuriousEvent() { add(spuriousEvents_, 1); }
+    void recordBulk(size_t n, bool carryOver)
+    {
+        add(bulkFunctors_, n);
+        if (carryOver)
+        {
+            add(bulkCarryOvers_, 1);
+        }
+    }
+    void recordFunctorCarryOver() { add(functorCarryOvers_, 1); }
+    void recordDeferredChannels(size_t n) { add(deferredChannels_, n); }
+    void recordZeroCopySend() { add(zeroCopySends_, 1); }
+    void recordZeroCopyCompletions(uint64_t n, bool copied)
+    {
+        add(zeroCopyCompletions_, n);
+        if (copied)
+        {
+            add(zeroCopyCopied_, n);
+        }
+    }
+
+    // 任意线程调用
+    Snapshot snapshot() const;
+    uint64_t wakeups() const { return wakeups_.load(std::memory_order_relaxed); }
+    uint64_t remoteFunctors() const { return remoteFunctors_.load(std::memory_order_relaxed); }
+    uint64_t busyPollHits() const { return busyPollHits_.load(std::memory_order_relaxed); }
+    uint64_t blockingPolls() const { return blockingPolls_.load(std::memory_order_relaxed); }
+    // 处理事件和回调的累计时间
+    uint64_t busyUs() const
+    {
+        return callbackUs_.load(std::memory_order_relaxed) + functorUs_.load(std::memory_order_relaxed);
+    }
+
+private:
+    using Counter = std::atomic<uint64_t>;
+
+    static void add(Counter &counter, uint64_t n)
+    {
+        counter.store(counter.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+
+    static int bucketOf(size_t numEvents)
+    {
+        int bucket = 0;
+        while (numEvents > 0 && bucket < kHistogramBuckets - 1)
+        {
+            numEvents >>= 1;
+            ++bucket;
+        }
+        return bucket;
+    }
+
+private:
+    // loop线程独占写入，放在单独的cache line，避免和EventLoop中其他线程写的成员伪共享
+    alignas(64) Counter iterations_{0};
+    Counter pollUs_{0};
+    Counter callbackUs_{0};
+    Counter functorUs_{0};
+    Counter functorDrains_{0};
+    Counter functors_{0};
+    Counter maxFunctorsPerDrain_{0};
+    Counter remoteFunctors_{0};
+    Counter events_{0};
+    Counter eventsPerPoll_[kHistogramBuckets] = {};
+    Counter wakeups_{0};
+    Counter busyPollHits_{0};
+    Counter blockingPolls_{0};
+    Counter pollerCtls_{0};
+    Counter pollerCtlsSkipped_{0};
+    Counter deferredDisarms_{0};
+    Counter spuriousEvents_{0};
+    Counter bulkFunctors_{0};
+    Counter bulkCarryOvers_{0};
+    Counter functorCarryOvers_{0};
+    Counter deferredChannels_{0};
+    Counter zeroCopySends_{0};
+    Counter zeroCopyCompletions_{0};
+    Counter zeroCopyCopied_{0};
+};
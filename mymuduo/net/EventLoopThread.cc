@@ -1,5 +1,6 @@
 #include "EventLoopThread.h"
 #include "EventLoop.h"
+#include "CpuAffinity.h"
 
 EventLoopThread::EventLoopThread(const ThreadInitCallback &cb, 
         const std::string &name)
@@ -42,6 +43,12 @@ EventLoop *EventLoopThread::startLoop()
 // 创建一个eventloop并调用loop()函数循环
 void EventLoopThread::threadFunc()
 {
+    // 先绑核再创建loop，Linux按首次访问分配物理页，loop的内存落在本地节点上
+    if (!cpus_.empty())
+    {
+        CpuAffinity::bindCurrentThread(cpus_);
+    }
+
     EventLoop loop; // 创建一个独立的eventLoop，和上面的线程一一对应，one loop per thread
 
     if (callback_)
@@ -2,6 +2,7 @@
 #include <functional>
 #include <mutex>
 #include <condition_variable>
+#include <vector>
 #include "noncopyable.h"
 #include "Thread.h"
 
@@ -16,6 +17,10 @@ public:
             const std::string &name = std::string());
     ~EventLoopThread();
 
+    // 线程启动后先绑定到cpus，再创建EventLoop，需要在startLoop之前调用，为空表示不绑定
+    // loop及其Poller、之后在该线程中创建的连接都在绑定的CPU所在的NUMA节点上分配内存
+    void setCpuAffinity(const std::vector<int> &cpus) { cpus_ = cpus; }
+
     EventLoop *startLoop();
 
 private:
@@ -28,4 +33,5 @@ private:
     std::mutex mutex_;
     std::condition_variable cond_;
     ThreadInitCallback callback_;
+    std::vector<int> cpus_;
 };
\ No newline at end of file
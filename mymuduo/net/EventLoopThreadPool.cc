@@ -1,5 +1,14 @@
 #include "EventLoopThreadPool.h"
 #include "EventLoopThread.h"
+#include "EventLoop.h"
+#include "CpuAffinity.h"
+#include "Logger.h"
+#include "InetAddress.h"
+#include "Timestamp.h"
+
+// kLeastBusy重新读取loop忙碌时间的间隔，各loop的负载在两次采样之间视为不变，
+// 随机二选一保证这段时间内的新连接不会都涌向同一个loop
+static const int64_t kLoadSampleUs = 100 * 1000;
 
 EventLoopThreadPool::EventLoopThreadPool(EventLoop *baseLoop, const std::string &nameArg)
         : baseLoop_(baseLoop)
@@ -7,6 +16,11 @@ EventLoopThreadPool::EventLoopThreadPool(EventLoop *baseLoop, const std::string
         , started_(false)
         , numThreads_(0)
         , next_(0)
+        , busyPollUs_(0)
+        , affinity_(kNoAffinity)
+        , balance_(kRoundRobin)
+        , lastSampleUs_(0)
+        , random_(static_cast<uint32_t>(Timestamp::now().microSecondsSinceEpoch()) | 1)
 {
 }
 
@@ -18,14 +32,18 @@ void EventLoopThreadPool::start(const ThreadInitCallback &cb)
 {
     started_ = true;
 
+    std::vector<std::vector<int>> plan = affinityPlan();
     for (int i = 0; i < numThreads_; i++)
     {
         char buf[name_.size() + 32];
         snprintf(buf, sizeof(buf), "%s%d", name_.c_str(), i);
         EventLoopThread *t = new EventLoopThread(cb, buf);
+        t->setCpuAffinity(plan[i]);
         threads_.push_back(std::unique_ptr<EventLoopThread>(t));
         loops_.push_back(t->startLoop());   // 底层创建线程。绑定一个新的EventLoop，并返回该loop的地址
+        loops_.back()->setBusyPollBudget(busyPollUs_);
     }
+    loadSamples_.resize(loops_.size());
 
     // 整个服务端只有一个线程，运行着baseloop
     if (numThreads_ == 0 && cb)
@@ -34,6 +52,63 @@ void EventLoopThreadPool::start(const ThreadInitCallback &cb)
     }
 }
 
+void EventLoopThreadPool::setAffinity(AffinityPolicy policy, const std::vector<int> &ids)
+{
+    affinity_ = policy;
+    affinityIds_ = ids;
+}
+
+std::vector<std::vector<int>> EventLoopThreadPool::affinityPlan() const
+{
+    std::vector<std::vector<int>> plan(numThreads_);
+    if (affinity_ == kNoAffinity || numThreads_ == 0)
+    {
+        return plan;
+    }
+
+    if (affinity_ == kNumaNode)
+    {
+        // 每个节点的所有CPU都给绑定到该节点的loop，由调度器在节点内均衡
+        std::vector<int> nodes = affinityIds_.empty() ? CpuAffinity::numaNodes() : affinityIds_;
+        std::vector<std::vector<int>> nodeCpus;
+        for (int node: nodes)
+        {
+            nodeCpus.push_back(CpuAffinity::nodeCpus(node));
+            if (nodeCpus.back().empty())
+            {
+                LOG_ERROR << "EventLoopThreadPool " << name_ << " NUMA node " << node << " has no usable cpu";
+            }
+        }
+        for (int i = 0; i < numThreads_; i++)
+        {
+            plan[i] = nodeCpus[i % nodeCpus.size()];
+        }
+        return plan;
+    }
+
+    std::vector<int> cpus = (affinity_ == kCpuList) ? affinityIds_ : CpuAffinity::physicalCores();
+    if (cpus.empty())
+    {
+        LOG_ERROR << "EventLoopThreadPool " << name_ << " no cpu for affinity policy " << affinity_;
+        return plan;
+    }
+    for (int i = 0; i < numThreads_; i++)
+    {
+        plan[i].push_back(cpus[i % cpus.size()]);
+    }
+    return plan;
+}
+
+// 只作用于subloop，baseLoop_由用户自己设置
+void EventLoopThreadPool::setBusyPollBudget(int64_t microSeconds)
+{
+    busyPollUs_ = microSeconds;
+    for (EventLoop *loop: loops_)
+    {
+        loop->setBusyPollBudget(microSeconds);
+    }
+}
+
 // 如果工作在多线程中，baseLoop_默认以轮询的方式分配channel给subloop
 EventLoop *EventLoopThreadPool::getNextLoop()
 {
@@ -52,6 +127,101 @@ EventLoop *EventLoopThreadPool::getNextLoop()
     return loop;
 }
 
+EventLoop *EventLoopThreadPool::getNextLoop(const InetAddress &peerAddr)
+{
+    if (loops_.empty())
+    {
+        return baseLoop_;
+    }
+    if (chooser_)
+    {
+        return chooser_(loops_, peerAddr);
+    }
+
+    switch (balance_)
+    {
+    case kLeastConnections:
+        return leastConnectionsLoop();
+    case kLeastBusy:
+        return leastBusyLoop();
+    case kPeerHash:
+    {
+        // murmur3的fmix32，把同一网段内相近的IP打散
+        uint32_t hash = ntohl(peerAddr.getSockAddr()->sin_addr.s_addr);
+        hash ^= hash >> 16;
+        hash *= 0x85ebca6b;
+        hash ^= hash >> 13;
+        hash *= 0xc2b2ae35;
+        hash ^= hash >> 16;
+        return loops_[hash % loops_.size()];
+    }
+    case kRoundRobin:
+    default:
+        return getNextLoop();
+    }
+}
+
+EventLoop *EventLoopThreadPool::leastConnectionsLoop()
+{
+    // 从轮询位置开始找，连接数相同时依次分配而不是总落在第一个loop
+    size_t n = loops_.size();
+    size_t best = next_ % n;
+    for (size_t k = 1; k < n; k++)
+    {
+        size_t i = (next_ + k) % n;
+        if (loops_[i]->numConnections() < loops_[best]->numConnections())
+        {
+            best = i;
+        }
+    }
+    next_ = static_cast<int>((best + 1) % n);
+    return loops_[best];
+}
+
+EventLoop *EventLoopThreadPool::leastBusyLoop()
+{
+    size_t n = loops_.size();
+    if (n == 1)
+    {
+        return loops_[0];
+    }
+    // xorshift32
+    random_ ^= random_ << 13;
+    random_ ^= random_ >> 17;
+    random_ ^= random_ << 5;
+    size_t a = random_ % n;
+    size_t b = (a + 1 + (random_ >> 16) % (n - 1)) % n;    // 与a不同的另一个loop
+
+    sampleLoads(Timestamp::monotonicNow().microSecondsSinceEpoch());
+    double busyA = loadSamples_[a].busyRatio;
+    double busyB = loadSamples_[b].busyRatio;
+    if (busyA != busyB)
+    {
+        return loops_[busyA < busyB ? a : b];
+    }
+    return loops_[loops_[a]->numConnections() <= loops_[b]->numConnections() ? a : b];
+}
+
+void EventLoopThreadPool::sampleLoads(int64_t nowUs)
+{
+    // 所有loop一起采样，比较的是同一时间窗口内的忙碌程度
+    if (nowUs - lastSampleUs_ < kLoadSampleUs)
+    {
+        return;
+    }
+    for (size_t i = 0; i < loops_.size(); i++)
+    {
+        LoadSample &sample = loadSamples_[i];
+        uint64_t busyUs = loops_[i]->busyMicroSeconds();
+        if (lastSampleUs_ > 0)
+        {
+            sample.busyRatio = static_cast<double>(busyUs - sample.busyUs) / (nowUs - lastSampleUs_);
+        }
+        sample.busyUs = busyUs;
+    }
+    lastSampleUs_ = nowUs;
+}
+
 std::vector<EventLoop *> EventLoopThreadPool::getAllLoops()
 {
     if (loops_.empty())
@@ -62,4 +232,24 @@ std::vector<EventLoop *> EventLoopThreadPool::getAllLoops()
     {
         return loops_;
     }
+}
+
+std::vector<EventLoopStats::Snapshot> EventLoopThreadPool::statsPerLoop()
+{
+    std::vector<EventLoopStats::Snapshot> result;
+    for (EventLoop *loop: getAllLoops())
+    {
+        result.push_back(loop->stats());
+    }
+    return result;
+}
+
+EventLoopStats::Snapshot EventLoopThreadPool::stats()
+{
+    EventLoopStats::Snapshot total;
+    for (EventLoop *loop: getAllLoops())
+    {
+        total += loop->stats();
+    }
+    return total;
 }
\ No newline at end of file
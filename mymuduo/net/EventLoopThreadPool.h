@@ -4,33 +4,99 @@
 #include <vector>
 #include <memory>
 #include "noncopyable.h"
+#include "EventLoopStats.h"
 
 class EventLoop;
 class EventLoopThread;
+class InetAddress;
 
 class EventLoopThreadPool: noncopyable
 {
 public:
     using ThreadInitCallback = std::function<void(EventLoop *)>;
 
+    // subloop线程的绑核策略
+    enum AffinityPolicy
+    {
+        kNoAffinity,        // 不绑定，由调度器决定（默认）
+        kCpuList,           // 第i个loop绑定到ids[i % n]号CPU
+        kPhysicalCore,      // 每个loop绑定一个物理核（不与其他loop共用超线程），核数不够时循环使用
+        kNumaNode,          // 第i个loop绑定到ids[i % n]号NUMA节点的所有CPU，ids为空时使用所有节点
+    };
+
+    // 新连接分配到subloop的策略
+    enum LoadBalance
+    {
+        kRoundRobin,        // 轮询（默认）
+        kLeastConnections,  // 当前连接数最少的loop，连接数相同时轮询
+        kLeastBusy,         // 随机取两个loop，选近期忙碌时间占比低的（power of two choices）
+        kPeerHash,          // 按对端IP哈希，同一个客户端总是分到同一个loop
+    };
+    // 自定义策略，参数为所有subloop和新连接的对端地址，返回其中一个loop
+    using LoopChooser = std::function<EventLoop *(const std::vector<EventLoop *> &, const InetAddress &)>;
+
     EventLoopThreadPool(EventLoop *baseLoop, const std::string &nameArg);
     ~EventLoopThreadPool();
 
     void setThreadNum(int numThreads) { numThreads_ = numThreads; }
+    int numThreads() const { return numThreads_; }
+    // subloop的忙轮询预算，单位微秒，0表示关闭，start之后调用也会生效
+    void setBusyPollBudget(int64_t microSeconds);
+    // 设置绑核策略，需要在start之前调用
+    // 线程先绑核再创建loop，loop的内存以及在loop线程中创建的连接都分配在本地NUMA节点上
+    void setAffinity(AffinityPolicy policy, const std::vector<int> &ids = std::vector<int>());
     void start(const ThreadInitCallback &cb = ThreadInitCallback());
 
+    // 设置分配策略，只能在baseLoop线程调用
+    void setLoadBalance(LoadBalance policy) { balance_ = policy; }
+    // 设置自定义策略，非空时优先于setLoadBalance，只能在baseLoop线程调用
+    void setLoopChooser(LoopChooser chooser) { chooser_ = std::move(chooser); }
+    LoadBalance loadBalance() const { return balance_; }
+    bool hasLoopChooser() const { return static_cast<bool>(chooser_); }
+
     // 如果工作在多线程中，baseLoop_默认以轮询的方式分配channel给subloop
     EventLoop *getNextLoop();
+    // 按分配策略为对端地址为peerAddr的新连接选择loop，只能在baseLoop线程调用
+    EventLoop *getNextLoop(const InetAddress &peerAddr);
     std::vector<EventLoop *> getAllLoops();
+
+    // 每个loop的运行统计，顺序与getAllLoops()一致，start之后可在任意线程调用
+    // 用来找出负载偏高的loop，以及判断线程数是否合适
+    std::vector<EventLoopStats::Snapshot> statsPerLoop();
+    // 所有loop的运行统计之和
+    EventLoopStats::Snapshot stats();
     bool started() const { return started_; }
     const std::string name() { return name_; }
 
+private:
+    // 按绑核策略计算每个loop绑定的CPU，不绑定的loop对应空集合
+    std::vector<std::vector<int>> affinityPlan() const;
+    EventLoop *leastConnectionsLoop();
+    EventLoop *leastBusyLoop();
+    // 距上次采样超过kLoadSampleUs时，重新计算各loop在这段时间内处理事件和回调的时间占比
+    void sampleLoads(int64_t nowUs);
+
 private:
     EventLoop *baseLoop_;
     std::string name_;
     bool started_;
     int numThreads_;
     int next_;
+    int64_t busyPollUs_;
+    AffinityPolicy affinity_;
+    std::vector<int> affinityIds_;
     std::vector<std::unique_ptr<EventLoopThread>> threads_;
     std::vector<EventLoop *> loops_;
+
+    // kLeastBusy的采样状态，只在baseLoop线程访问
+    struct LoadSample
+    {
+        uint64_t busyUs = 0;        // 上次采样时loop的累计忙碌时间
+        double busyRatio = 0.0;     // 最近一个采样周期的忙碌时间占比
+    };
+    LoadBalance balance_;
+    LoopChooser chooser_;
+    std::vector<LoadSample> loadSamples_;
+    int64_t lastSampleUs_;
+    uint32_t random_;
 };
\ No newline at end of file
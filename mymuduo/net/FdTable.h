@@ -0,0 +1,98 @@
+#pragma once
+#include <memory>
+#include <vector>
+#include <stddef.h>
+#include <stdint.h>
+#include "noncopyable.h"
+
+/**
+ * @brief
+ * 以fd为下标的两级表，替代unordered_map<int, T>
+ * fd是从小到大分配的稠密整数，第一级是页目录，第二级是固定大小的页，
+ * 页在第一次用到时分配且之后不再释放，因此连接反复建立和关闭时
+ * insert/erase/find都只是下标运算，不哈希也不分配内存
+ * 很大的fd只会多分配它所在的一页，不需要把整张表扩展到fd的大小
+ * 不是线程安全的，只在所属的loop线程中使用
+ */
+template<typename T>
+class FdTable: noncopyable
+{
+public:
+    FdTable(): size_(0) {}
+
+    // 插入或覆盖fd对应的值
+    T &insert(int fd, const T &value)
+    {
+        Page *page = getPage(fd);
+        const int slot = fd & kPageMask;
+        if (!page->test(slot))
+        {
+            page->set(slot);
+            ++size_;
+        }
+        page->values[slot] = value;
+        return page->values[slot];
+    }
+
+    // 删除fd对应的值，不存在时什么也不做
+    void erase(int fd)
+    {
+        Page *page = findPage(fd);
+        const int slot = fd & kPageMask;
+        if (page && page->test(slot))
+        {
+            page->reset(slot);
+            page->values[slot] = T();
+            --size_;
+        }
+    }
+
+    // 不存在时返回nullptr
+    T *find(int fd) const
+    {
+        Page *page = findPage(fd);
+        const int slot = fd & kPageMask;
+        return page && page->test(slot) ? &page->values[slot] : nullptr;
+    }
+
+    size_t size() const { return size_; }
+
+private:
+    static const int kPageShift = 10;
+    static const int kPageSize = 1 << kPageShift;
+    static const int kPageMask = kPageSize - 1;
+
+    struct Page
+    {
+        T values[kPageSize];
+        uint64_t used[kPageSize / 64] = {};  // 占用位图
+
+        bool test(int slot) const { return used[slot >> 6] & (1ULL << (slot & 63)); }
+        void set(int slot) { used[slot >> 6] |= 1ULL << (slot & 63); }
+        void reset(int slot) { used[slot >> 6] &= ~(1ULL << (slot & 63)); }
+    };
+
+    Page *findPage(int fd) const
+    {
+        size_t idx = static_cast<size_t>(fd) >> kPageShift;
+        return fd >= 0 && idx < pages_.size() ? pages_[idx].get() : nullptr;
+    }
+
+    Page *getPage(int fd)
+    {
+        size_t idx = static_cast<size_t>(fd) >> kPageShift;
+        if (idx >= pages_.size())
+        {
+            pages_.resize(idx + 1);
+        }
+        if (!pages_[idx])
+        {
+            pages_[idx].reset(new Page());
+        }
+        return pages_[idx].get();
+    }
+
+private:
+    std::vector<std::unique_ptr<Page>> pages_;  // 页目录
+    size_t size_;
+};
@@ -0,0 +1,117 @@
+#include "PollPoller.h"
+#include "Logger.h"
+#include "Channel.h"
+#include <sys/epoll.h>
+#include <errno.h>
+
+// channel未添加到poller中，channel的成员index_ = -1
+const int kNew = -1;
+
+PollPoller::PollPoller(EventLoop *loop)
+        : Poller(loop)
+{
+}
+
+PollPoller::~PollPoller() = default;
+
+// 封装了poll
+Timestamp PollPoller::poll(int timeoutMs, ChannelList *activeChannels)
+{
+    LOG_DEBUG << "func = " << __FUNCTION__ << " -> fd total count: " << pollfds_.size();
+
+    int numEvents = ::poll(pollfds_.data(), pollfds_.size(), timeoutMs);
+    int saveErrno = errno;
+    Timestamp now(Timestamp::now());
+
+    if (numEvents > 0)
+    {
+        LOG_DEBUG << numEvents << " events happened";
+        fillActiveChannels(numEvents, activeChannels);
+    }
+    else if (numEvents == 0)
+    {
+        LOG_DEBUG << __FUNCTION__ << " timeout!";
+    }
+    else
+    {
+        if (saveErrno != EINTR)
+        {
+            errno = saveErrno;
+            LOG_ERROR << "PollPoller::poll() error!";
+        }
+    }
+    return now;
+}
+
+void PollPoller::fillActiveChannels(int numEvents, ChannelList *activeChannels) const
+{
+    for (auto pfd = pollfds_.begin(); pfd != pollfds_.end() && numEvents > 0; ++pfd)
+    {
+        if (pfd->revents > 0)
+        {
+            --numEvents;
+            Channel *channel = *channels_.find(pfd->fd);
+            // poll与epoll的事件位取值相同
+            channel->set_revents(pfd->revents);
+            activeChannels->push_back(channel);
+        }
+    }
+}
+
+void PollPoller::updateChannel(Channel *channel)
+{
+    LOG_DEBUG << "func = " << __FUNCTION__
+            << " -> fd = " << channel->fd()
+            << " events = " << channel->events()
+            << " index = " << channel->index();
+
+    if (channel->isEdgeTriggered())
+    {
+        LOG_ERROR << "PollPoller does not support edge-triggered channel, fd = " << channel->fd();
+    }
+
+    if (channel->index() == kNew)
+    {
+        // 新的channel追加到数组末尾
+        struct pollfd pfd;
+        pfd.fd = channel->fd();
+        pfd.events = static_cast<short>(channel->events() & ~EPOLLET);
+        pfd.revents = 0;
+        pollfds_.push_back(pfd);
+        channel->set_index(static_cast<int>(pollfds_.size()) - 1);
+        channels_.insert(pfd.fd, channel);
+    }
+    else
+    {
+        struct pollfd &pfd = pollfds_[channel->index()];
+        pfd.fd = channel->fd();
+        pfd.events = static_cast<short>(channel->events() & ~EPOLLET);
+        pfd.revents = 0;
+        if (channel->isNoneEvent())
+        {
+            // 不关注任何事件时把fd置为负数，poll会忽略该项
+            pfd.fd = -channel->fd() - 1;
+        }
+    }
+}
+
+void PollPoller::removeChannel(Channel *channel)
+{
+    LOG_DEBUG << "func = " << __FUNCTION__ << " -> fd = " << channel->fd();
+
+    int idx = channel->index();
+    channels_.erase(channel->fd());
+    if (idx != static_cast<int>(pollfds_.size()) - 1)
+    {
+        // 与最后一个元素交换，并更新被移动channel的下标
+        int lastFd = pollfds_.back().fd;
+        if (lastFd < 0)
+        {
+            lastFd = -lastFd - 1;
+        }
+        std::swap(pollfds_[idx], pollfds_.back());
+        (*channels_.find(lastFd))->set_index(idx);
+    }
+    pollfds_.pop_back();
+    channel->set_index(kNew);
+}
@@ -0,0 +1,32 @@
+#pragma once
+#include <vector>
+#include <poll.h>
+#include "Poller.h"
+#include "Timestamp.h"
+
+class Channel;
+
+/**
+ * @brief
+ * 基于poll(2)的Poller，所有pollfd存放在一段连续的数组中，fd较少时对cache更友好
+ * channel的index_即为其pollfd在数组中的下标，删除时与最后一个元素交换后pop_back，O(1)
+ * poll只支持水平触发，因此不支持边缘触发的channel
+ */
+class PollPoller: public Poller
+{
+public:
+    PollPoller(EventLoop *loop);
+    ~PollPoller() override;
+
+    Timestamp poll(int timeoutMs, ChannelList *activeChannels) override;
+    void updateChannel(Channel *channel) override;
+    void removeChannel(Channel *channel) override;
+    bool edgeTriggeredSupported() const override { return false; }
+
+private:
+    void fillActiveChannels(int numEvents, ChannelList *activeChannels) const;
+
+private:
+    using PollFdList = std::vector<struct pollfd>;
+    PollFdList pollfds_;
+};
@@ -1,10 +1,15 @@
 #include "Poller.h"
 #include "Channel.h"
+#include "EventLoop.h"
 
-Poller::Poller(EventLoop *loop): ownerLoop_(loop) {}
+Poller::Poller(EventLoop *loop)
+        : stats_(loop->mutableStats())
+        , ownerLoop_(loop)
+{
+}
 
 bool Poller::hasChannel(Channel *channel) const
 {
-    auto it = channels_.find(channel->fd());
-    return it != channels_.end() && it->second == channel;
+    Channel **it = channels_.find(channel->fd());
+    return it != nullptr && *it == channel;
 }
\ No newline at end of file
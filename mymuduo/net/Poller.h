@@ -1,11 +1,12 @@
 #pragma once
 #include <vector>
-#include <unordered_map>
 #include "noncopyable.h"
 #include "Timestamp.h"
+#include "FdTable.h"
 
 class Channel;
 class EventLoop;
+class EventLoopStats;
 
 // muduo库中多路事件分发器的核心IO复用模块
 class Poller: noncopyable
@@ -24,13 +25,21 @@ public:
     // 判断参数channel是否在当前Poller当中
     bool hasChannel(Channel *channel) const;
 
+    // 是否支持边缘触发的channel
+    virtual bool edgeTriggeredSupported() const { return true; }
+
+    // 延迟取消写事件的轮数，见EventLoop::setLazyWriteDisarm，默认不支持
+    virtual void setLazyWriteDisarm(int /*iterations*/) {}
+
     // EventLoop可以通过该接口获取默认的IO复用的具体实现
     static Poller *newDefaultPoller(EventLoop *loop);
 
 protected:
     // key: sockfd, value: sockfd所属的channel通道类型
-    using ChannelMap = std::unordered_map<int, Channel *>;
-    ChannelMap channels_;    
+    // fd是稠密的小整数，直接按fd下标查找，增删连接时不哈希也不分配节点
+    using ChannelMap = FdTable<Channel *>;
+    ChannelMap channels_;
+    EventLoopStats *stats_;     // 所属EventLoop的运行统计
 
 private:
     EventLoop *ownerLoop_;  // 定义Poller所属的事件循环EventLoop
@@ -0,0 +1,132 @@
+#pragma once
+#include <vector>
+#include <stddef.h>
+#include <stdint.h>
+#include "noncopyable.h"
+
+/**
+ * @brief
+ * 用64位id索引的稠密表，替代以字符串为key的unordered_map
+ * id = 表的编号(16位) | 槽位的代数(16位) | 槽位下标(32位)
+ * 槽位释放后放入空闲链表，下次insert优先复用；每次释放槽位代数加1，
+ * 因此已删除元素的旧id不会误找到复用该槽位的新元素
+ * insert/erase/find都只是下标运算，表扩展之后不再分配内存
+ * 不是线程安全的，只在所属的loop线程中使用；insert可能使find返回的指针失效
+ */
+template<typename T>
+class SlotTable: noncopyable
+{
+public:
+    using Id = uint64_t;
+
+    explicit SlotTable(uint16_t owner = 0)
+            : owner_(owner)
+            , freeHead_(kNoSlot)
+            , size_(0)
+    {
+    }
+
+    uint16_t owner() const { return owner_; }
+    // id所属表的编号
+    static uint16_t ownerOf(Id id) { return static_cast<uint16_t>(id >> 48); }
+
+    // 占用一个槽位并返回其id
+    Id insert(const T &value)
+    {
+        uint32_t index = freeHead_;
+        if (index != kNoSlot)
+        {
+            freeHead_ = slots_[index].nextFree;
+        }
+        else
+        {
+            index = static_cast<uint32_t>(slots_.size());
+            slots_.emplace_back();
+        }
+        Slot &slot = slots_[index];
+        slot.used = true;
+        slot.value = value;
+        ++size_;
+        return makeId(slot.generation, index);
+    }
+
+    // 删除id对应的元素，id已失效时返回false
+    bool erase(Id id)
+    {
+        Slot *slot = lookup(id);
+        if (slot == nullptr)
+        {
+            return false;
+        }
+        uint32_t index = static_cast<uint32_t>(id);
+        slot->value = T();
+        slot->used = false;
+        ++slot->generation;
+        slot->nextFree = freeHead_;
+        freeHead_ = index;
+        --size_;
+        return true;
+    }
+
+    // 不存在或已失效时返回nullptr
+    T *find(Id id)
+    {
+        Slot *slot = lookup(id);
+        return slot ? &slot->value : nullptr;
+    }
+
+    // 按槽位顺序访问所有元素，func(Id, T &)
+    template<typename Func>
+    void forEach(Func func)
+    {
+        for (uint32_t i = 0; i < slots_.size(); i++)
+        {
+            if (slots_[i].used)
+            {
+                func(makeId(slots_[i].generation, i), slots_[i].value);
+            }
+        }
+    }
+
+    void clear()
+    {
+        slots_.clear();
+        freeHead_ = kNoSlot;
+        size_ = 0;
+    }
+
+    size_t size() const { return size_; }
+
+private:
+    static const uint32_t kNoSlot = UINT32_MAX;
+
+    struct Slot
+    {
+        T value;
+        uint32_t nextFree = kNoSlot;  // 空闲链表中的下一个槽位
+        uint16_t generation = 0;
+        bool used = false;
+    };
+
+    Id makeId(uint16_t generation, uint32_t index) const
+    {
+        return (static_cast<Id>(owner_) << 48) | (static_cast<Id>(generation) << 32) | index;
+    }
+
+    Slot *lookup(Id id)
+    {
+        uint32_t index = static_cast<uint32_t>(id);
+        if (ownerOf(id) != owner_ || index >= slots_.size())
+        {
+            return nullptr;
+        }
+        Slot &slot = slots_[index];
+        return slot.used && slot.generation == static_cast<uint16_t>(id >> 32) ? &slot : nullptr;
+    }
+
+private:
+    const uint16_t owner_;
+    std::vector<Slot> slots_;
+    uint32_t freeHead_;     // 空闲链表头
+    size_t size_;
+};
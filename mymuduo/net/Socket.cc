@@ -6,6 +6,9 @@
 #include <sys/socket.h>
 #include <strings.h>
 #include <netinet/tcp.h>
+#include <linux/filter.h>
+#include <errno.h>
+#include <fcntl.h>
 
 Socket::~Socket()
 {
@@ -20,11 +23,11 @@ void Socket::bindAddress(const InetAddress &localaddr)
     }
 }
 
-void Socket::listen()
+void Socket::listen(int backlog)
 {
-    if (0 != ::listen(sockfd_, 1024))
+    if (0 != ::listen(sockfd_, backlog))
     {
-        LOG_FATAL << "bind sockfd: " << sockfd_ << "fali";
+        LOG_FATAL << "listen sockfd: " << sockfd_ << " backlog: " << backlog << " fail";
     }
 }
 
@@ -33,7 +36,7 @@ int Socket::accept(InetAddress &peeraddr)
     struct sockaddr_in addr;
     socklen_t len = sizeof(addr);
     bzero(&addr, sizeof(addr));
-    int connfd = ::accept(sockfd_, (struct sockaddr *)&addr, &len);
+    int connfd = ::accept4(sockfd_, (struct sockaddr *)&addr, &len, SOCK_NONBLOCK | SOCK_CLOEXEC);
     if (connfd >= 0)
     {
         peeraddr.setSockAddr(addr);
@@ -67,8 +70,67 @@ void Socket::setReusePort(bool on)
     ::setsockopt(sockfd_, SOL_SOCKET, SO_REUSEPORT, &optval, sizeof(optval));
 }
 
+bool Socket::setReusePortCpuSteering(int numSockets)
+{
+    // A = 当前CPU编号; A = A % numSockets; return A
+    struct sock_filter code[] = {
+        { BPF_LD | BPF_W | BPF_ABS, 0, 0, static_cast<uint32_t>(SKF_AD_OFF + SKF_AD_CPU) },
+        { BPF_ALU | BPF_MOD | BPF_K, 0, 0, static_cast<uint32_t>(numSockets) },
+        { BPF_RET | BPF_A, 0, 0, 0 },
+    };
+    struct sock_fprog prog;
+    prog.len = sizeof(code) / sizeof(code[0]);
+    prog.filter = code;
+    if (numSockets <= 0
+            || ::setsockopt(sockfd_, SOL_SOCKET, SO_ATTACH_REUSEPORT_CBPF, &prog, sizeof(prog)) < 0)
+    {
+        LOG_ERROR << "Socket::setReusePortCpuSteering sockfd: " << sockfd_ << " errno: " << errno;
+        return false;
+    }
+    return true;
+}
+
+void Socket::setNonBlocking()
+{
+    int flags = ::fcntl(sockfd_, F_GETFL, 0);
+    if (flags >= 0 && !(flags & O_NONBLOCK))
+    {
+        ::fcntl(sockfd_, F_SETFL, flags | O_NONBLOCK);
+    }
+}
+
 void Socket::setKeepAlive(bool on)
 {
     int optval = on ? 1 : 0;
     ::setsockopt(sockfd_, SOL_SOCKET, SO_KEEPALIVE, &optval, sizeof(optval));
+}
+
+void Socket::setAbortOnClose()
+{
+    struct linger lin;
+    lin.l_onoff = 1;
+    lin.l_linger = 0;
+    if (::setsockopt(sockfd_, SOL_SOCKET, SO_LINGER, &lin, sizeof(lin)) < 0)
+    {
+        LOG_ERROR << "setsockopt SO_LINGER error: " << errno;
+    }
+}
+
+void Socket::setBusyPoll(int microSeconds)
+{
+    if (::setsockopt(sockfd_, SOL_SOCKET, SO_BUSY_POLL, &microSeconds, sizeof(microSeconds)) < 0)
+    {
+        LOG_ERROR << "setsockopt SO_BUSY_POLL error: " << errno;
+    }
+}
+
+bool Socket::setZeroCopy(bool on)
+{
+    int optval = on ? 1 : 0;
+    if (::setsockopt(sockfd_, SOL_SOCKET, SO_ZEROCOPY, &optval, sizeof(optval)) < 0)
+    {
+        LOG_ERROR << "setsockopt SO_ZEROCOPY error: " << errno;
+        return false;
+    }
+    return true;
 }
\ No newline at end of file
@@ -7,12 +7,16 @@ class InetAddress;
 class Socket: noncopyable
 {
 public:
+    static const int kDefaultBacklog = 1024;
+
     explicit Socket(int sockfd): sockfd_(sockfd) {}
     ~Socket();
 
     int fd() const { return sockfd_; }
     void bindAddress(const InetAddress &localaddr);
-    void listen();
+    // backlog为已完成握手、等待accept的连接队列长度，内核会截断到net.core.somaxconn
+    void listen(int backlog = kDefaultBacklog);
+    // 返回的连接socket已设置SOCK_NONBLOCK和SOCK_CLOEXEC，失败返回-1，errno保留accept4的错误
     int accept(InetAddress &peeraddr);
 
     void shutdownWrite();
@@ -20,7 +24,18 @@ public:
     void setTcpNoDelay(bool on);
     void setReuseAddr(bool on);
     void setReusePort(bool on);
+    // 给本socket所在的SO_REUSEPORT组挂载一个cBPF程序，按处理SYN的CPU选择监听socket：
+    // CPU c上的连接交给组内第c % numSockets个socket（按listen的先后顺序），失败时返回false
+    bool setReusePortCpuSteering(int numSockets);
+    // 设置O_NONBLOCK，已经是非阻塞（例如accept4得到的fd）时不再调用F_SETFL
+    void setNonBlocking();
     void setKeepAlive(bool on);
+    // SO_LINGER {1, 0}，close时直接发送RST并丢弃发送队列中的数据，不再进入FIN_WAIT/TIME_WAIT
+    void setAbortOnClose();
+    // SO_BUSY_POLL，阻塞读时在网卡队列上忙等microSeconds微秒，超过系统默认值需要CAP_NET_ADMIN
+    void setBusyPoll(int microSeconds);
+    // SO_ZEROCOPY，允许之后的send带MSG_ZEROCOPY，内核不支持（4.14之前）时返回false
+    bool setZeroCopy(bool on);
 
 private:
     const int sockfd_;
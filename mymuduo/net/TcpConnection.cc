@@ -4,7 +4,25 @@
 #include "Channel.h"
 #include "EventLoop.h"
 #include <functional>
+#include <algorithm>
 #include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <unistd.h>
+#include <sys/sendfile.h>
+#include <linux/errqueue.h>
+#include <netinet/in.h>
+#include <stdio.h>
+
+// 边缘触发模式下每次写事件最多发送的字节数，超出的部分放到回调队列中继续，
+// 避免一个高吞吐连接独占loop；读的上限由EventLoop::setMaxReadBytesPerWakeup配置
+static const size_t kEdgeTriggeredWriteBudget = 256 * 1024;
+// 每次writev最多的段数
+static const int kMaxIovecs = IOV_MAX;
+// sendv发不完时，小于该大小的段追加到缓冲区，不单独排队，省掉一次分配和一个iovec
+static const size_t kMinQueuedSegmentBytes = 4096;
+// 零拷贝阈值的下限，不到一页的数据锁定页面得不偿失，这样的string也一定在堆上，移动时地址不变
+static const size_t kMinZeroCopyBytes = 4096;
 
 static EventLoop *CheckLoopNotNull(EventLoop *loop)
 {
@@ -18,39 +36,107 @@ static EventLoop *CheckLoopNotNull(EventLoop *loop)
 }
 
 TcpConnection::TcpConnection(EventLoop *loop,
-        const std::string &nameArg,
+        Id id,
+        std::shared_ptr<const std::string> namePrefix,
         int sockfd,
         const InetAddress &localAddr,
         const InetAddress &peerAddr)
         : loop_(CheckLoopNotNull(loop))
-        , name_(nameArg)
+        , id_(id)
+        , namePrefix_(std::move(namePrefix))
         , state_(kConnecting)
         , reading_(true)
-        , socket_(new Socket(sockfd))
-        , channel_(new Channel(loop, sockfd))
+        , edgeTriggered_(false)
+        , socket_(sockfd)
+        , channel_(loop, sockfd)
         , localAddr_(localAddr)
         , peerAddr_(peerAddr)
         , highWaterMark_(64 * 1024 * 1024)  // 64M
+        , queuedBytes_(0)
+        , zeroCopyThreshold_(0)
+        , idleTimeout_(0.0)
 {
-    channel_->setReadCallback(
+    channel_.setReadCallback(
         std::bind(&TcpConnection::handleRead, this, std::placeholders::_1));
-    channel_->setWriteCallback(
+    channel_.setWriteCallback(
         std::bind(&TcpConnection::handleWrite, this));
-    channel_->setCloseCallback(
+    channel_.setCloseCallback(
         std::bind(&TcpConnection::handleClose, this));
-    channel_->setErrorCallback(
+    channel_.setErrorCallback(
         std::bind(&TcpConnection::handleError, this));
     
     // LOG_INFO("TcpConnection::ctor[%s] at fd = %d\n", name_.c_str(), sockfd);
-    LOG_INFO << "TcpConnection::ctor[" << name_ << "] at fd = " << sockfd;
-    socket_->setKeepAlive(true);
+    LOG_DEBUG << "TcpConnection::ctor[" << name() << "] at fd = " << sockfd;
+    // 边缘触发要一直读写到EAGAIN，水平触发的sendInLoop也会直接write，阻塞的fd会卡住整个loop
+    // Acceptor用accept4得到的fd已经是非阻塞的，这里保证其他来源的fd也一样
+    socket_.setNonBlocking();
+    socket_.setKeepAlive(true);
 }
 
 TcpConnection::~TcpConnection()
 {
-    // LOG_INFO("TcpConnection::dtor[%s] at fd = %d state = %d\n", name_.c_str(), channel_->fd(), (int)state_);
-    LOG_INFO << "TcpConnection::dtor[" << name_ << "] at fd = " << channel_->fd()
+    // LOG_INFO("TcpConnection::dtor[%s] at fd = %d state = %d\n", name_.c_str(), channel_.fd(), (int)state_);
+    LOG_DEBUG << "TcpConnection::dtor[" << name() << "] at fd = " << channel_.fd()
             << " state = " << (int)state_;
+    if (outputQueue_)
+    {
+        bool zeroCopyInFlight = !outputQueue_->zeroCopyPinned.empty();
+        for (OutputSegment &segment: outputQueue_->segments)
+        {
+            if (segment.kind == OutputSegment::kFile)
+            {
+                ::close(segment.fd);
+            }
+            else if (segment.zeroCopied && !zeroCopyDone(segment.zeroCopyEnd))
+            {
+                zeroCopyInFlight = true;
+            }
+        }
+        if (zeroCopyInFlight)
+        {
+            // 零拷贝的数据还没有收到完成通知（forceClose或对端关闭时不会等待），内存随连接一起释放，
+            // 正常close会让内核继续重传这些页面，内存被复用后发出的是改写过的内容；
+            // 改为close时直接发送RST并丢弃发送队列，shutdown则会等到完成通知之后才关闭
+            socket_.setAbortOnClose();
+        }
+    }
+}
+
+std::string TcpConnection::idString(Id id)
+{
+    char buf[48];
+    snprintf(buf, sizeof(buf), "#%u.%u.%u",
+            static_cast<unsigned>(id >> 48),
+            static_cast<unsigned>(id & 0xFFFFFFFF),
+            static_cast<unsigned>((id >> 32) & 0xFFFF));
+    return buf;
+}
+
+std::string TcpConnection::name() const
+{
+    return namePrefix_ ? *namePrefix_ + idString(id_) : idString(id_);
+}
+
+void TcpConnection::setEdgeTriggered(bool on)
+{
+    edgeTriggered_ = on;
+    channel_.setEdgeTriggered(on);
+}
+
+void TcpConnection::setBusyPoll(int microSeconds)
+{
+    socket_.setBusyPoll(microSeconds);
+}
+
+void TcpConnection::setZeroCopyThreshold(size_t bytes)
+{
+    if (bytes > 0 && !socket_.setZeroCopy(true))
+    {
+        bytes = 0;
+    }
+    // 零拷贝的数据在finishFrontSegment中移动到zeroCopyPinned保留，
+    // 短字符串存放在string对象内部，移动会换地址，内核引用的仍是旧地址
+    zeroCopyThreshold_ = bytes > 0 ? std::max(bytes, kMinZeroCopyBytes) : 0;
 }
 
 void TcpConnection::send(const std::string &buf)
@@ -63,11 +149,102 @@ void TcpConnection::send(const std::string &buf)
         }
         else
         {
-            loop_->runInLoop(std::bind(&TcpConnection::sendInLoop, this, buf.c_str(), buf.size()));
+            // buf可能在回调执行之前就被释放，需要拷贝一份，同时持有连接防止其先被析构
+            loop_->runInLoop(std::bind(&TcpConnection::sendStringInLoop, shared_from_this(), buf));
+        }
+    }
+}
+
+void TcpConnection::send(std::string &&buf)
+{
+    if (state_ == kConnected)
+    {
+        if (zeroCopyThreshold_ > 0 && buf.size() >= zeroCopyThreshold_)
+        {
+            if (loop_->isInLoopThread())
+            {
+                sendZeroCopyInLoop(buf);
+            }
+            else
+            {
+                loop_->runInLoop(std::bind(&TcpConnection::sendZeroCopyInLoop, shared_from_this(), std::move(buf)));
+            }
+        }
+        else if (loop_->isInLoopThread())
+        {
+            sendInLoop(buf.c_str(), buf.size());
+        }
+        else
+        {
+            loop_->runInLoop(std::bind(&TcpConnection::sendStringInLoop, shared_from_this(), std::move(buf)));
+        }
+    }
+}
+
+void TcpConnection::sendv(const struct iovec *iov, int iovcnt)
+{
+    if (state_ == kConnected)
+    {
+        if (loop_->isInLoopThread())
+        {
+            sendvInLoop(iov, iovcnt, nullptr);
+        }
+        else
+        {
+            // 逐段拷贝，不拼接
+            std::vector<std::string> segments;
+            segments.reserve(iovcnt);
+            for (int i = 0; i < iovcnt; i++)
+            {
+                segments.emplace_back(static_cast<const char *>(iov[i].iov_base), iov[i].iov_len);
+            }
+            loop_->runInLoop(std::bind(&TcpConnection::sendStringsInLoop, shared_from_this(), std::move(segments)));
+        }
+    }
+}
+
+void TcpConnection::sendv(std::vector<std::string> &&segments)
+{
+    if (state_ == kConnected)
+    {
+        if (loop_->isInLoopThread())
+        {
+            sendStringsInLoop(segments);
+        }
+        else
+        {
+            loop_->runInLoop(std::bind(&TcpConnection::sendStringsInLoop, shared_from_this(), std::move(segments)));
+        }
+    }
+}
+
+void TcpConnection::sendFile(int fd, off_t offset, size_t len)
+{
+    if (state_ == kConnected && len > 0)
+    {
+        // 在调用线程dup，调用者返回后就可以关闭自己的fd
+        int fileFd = ::fcntl(fd, F_DUPFD_CLOEXEC, 0);
+        if (fileFd < 0)
+        {
+            LOG_ERROR << "TcpConnection::sendFile dup fd: " << fd << " errno: " << errno;
+            return;
+        }
+        if (loop_->isInLoopThread())
+        {
+            sendFileInLoop(fileFd, offset, len);
+        }
+        else
+        {
+            loop_->runInLoop(std::bind(&TcpConnection::sendFileInLoop, shared_from_this(), fileFd, offset, len));
         }
     }
 }
 
+void TcpConnection::sendStringInLoop(const std::string &message)
+{
+    sendInLoop(message.c_str(), message.size());
+}
+
 // 应用写得快，内核发得慢，需要把待发送数据写入缓冲区，而且设置了水位回调
 void TcpConnection::sendInLoop(const void *data, size_t len)
 {
@@ -81,11 +258,11 @@ void TcpConnection::sendInLoop(const void *data, size_t len)
         return;
     }
 
-    // 表示channel_第一次开始写数据，而且缓冲区没有待发送数据
-    // isWriting表示的是可写
-    if (!channel_->isWriting() && outputBuffer_.readableBytes() == 0)
+    // 缓冲区没有待发送数据，直接写
+    // 水平触发时有待发送数据等价于channel_.isWriting()，边缘触发时写事件一直是注册的
+    if (pendingOutputBytes() == 0)
     {
-        nwrote = ::write(channel_->fd(), data, len);
+        nwrote = ::write(channel_.fd(), data, len);
         if (nwrote >= 0)
         {
             remaining = len - nwrote;
@@ -114,18 +291,491 @@ void TcpConnection::sendInLoop(const void *data, size_t len)
     // 也就是调用TcpConnection::handleWrite方法，把发送缓冲区中的数据全部发送完成
     if (!faultError && remaining > 0)
     {
-        size_t oldLen = outputBuffer_.readableBytes();
+        size_t oldLen = pendingOutputBytes();
         if (oldLen + remaining >= highWaterMark_
                 && oldLen < highWaterMark_
                 && highWaterMarkCallback_)
         {
             loop_->queueInLoop(std::bind(highWaterMarkCallback_, shared_from_this(), oldLen + remaining));
         }
-        outputBuffer_.append((char *)data + nwrote, remaining);
-        if (!channel_->isWriting())
+        if (!hasQueuedSegments())
         {
-            channel_->enableWriting();  // 必须注册channel的写事件，否则poller不会给channel通知epollout
+            outputBuffer_.append((char *)data + nwrote, remaining);
         }
+        else
+        {
+            // 排在最后一个段之后
+            outputQueue_->segments.back().trailer.append((char *)data + nwrote, remaining);
+            queuedBytes_ += remaining;
+        }
+        if (!channel_.isWriting())
+        {
+            channel_.enableWriting();  // 必须注册channel的写事件，否则poller不会给channel通知epollout
+        }
+    }
+}
+
+void TcpConnection::sendStringsInLoop(std::vector<std::string> &segments)
+{
+    std::vector<struct iovec> iov(segments.size());
+    for (size_t i = 0; i < segments.size(); i++)
+    {
+        iov[i].iov_base = const_cast<char *>(segments[i].data());
+        iov[i].iov_len = segments[i].size();
+    }
+    sendvInLoop(iov.data(), static_cast<int>(iov.size()), segments.data());
+}
+
+void TcpConnection::sendvInLoop(const struct iovec *iov, int iovcnt, std::string *owned)
+{
+    if (state_ == kDisconnected)
+    {
+        LOG_ERROR << "disconnected, give up writing!";
+        return;
+    }
+
+    size_t total = 0;
+    for (int i = 0; i < iovcnt; i++)
+    {
+        total += iov[i].iov_len;
+    }
+    if (total == 0)
+    {
+        return;
+    }
+
+    // 已发出的字节数，以及第一个没有发完的段和该段已发出的字节数
+    size_t nwrote = 0;
+    int first = 0;
+    size_t firstOffset = 0;
+    bool faultError = false;
+    if (pendingOutputBytes() == 0)
+    {
+        while (first < iovcnt)
+        {
+            struct iovec batch[kMaxIovecs];
+            int count = 0;
+            size_t batchLen = 0;
+            for (int i = first; i < iovcnt && count < kMaxIovecs; i++)
+            {
+                size_t skip = i == first ? firstOffset : 0;
+                batch[count].iov_base = static_cast<char *>(iov[i].iov_base) + skip;
+                batch[count].iov_len = iov[i].iov_len - skip;
+                batchLen += batch[count++].iov_len;
+            }
+            ssize_t n = ::writev(channel_.fd(), batch, count);
+            if (n < 0)
+            {
+                if (errno == EINTR)
+                {
+                    continue;
+                }
+                if (errno != EWOULDBLOCK)
+                {
+                    LOG_ERROR << "TcpConnection::sendvInLoop";
+                    faultError = (errno == EPIPE || errno == ECONNRESET);
+                }
+                break;
+            }
+            nwrote += n;
+            // 前进到第一个没有发完的段
+            size_t advance = n;
+            while (first < iovcnt && advance >= iov[first].iov_len - firstOffset)
+            {
+                advance -= iov[first].iov_len - firstOffset;
+                firstOffset = 0;
+                ++first;
+            }
+            firstOffset += advance;
+            if (static_cast<size_t>(n) < batchLen)
+            {
+                break;
+            }
+        }
+        if (nwrote == total && writeCompleteCallback_)
+        {
+            loop_->queueInLoop(std::bind(writeCompleteCallback_, shared_from_this()));
+        }
+    }
+    if (faultError || nwrote == total)
+    {
+        return;
+    }
+
+    size_t oldLen = pendingOutputBytes();
+    size_t remaining = total - nwrote;
+    if (oldLen + remaining >= highWaterMark_
+            && oldLen < highWaterMark_
+            && highWaterMarkCallback_)
+    {
+        loop_->queueInLoop(std::bind(highWaterMarkCallback_, shared_from_this(), oldLen + remaining));
+    }
+    for (int i = first; i < iovcnt; i++)
+    {
+        size_t skip = i == first ? firstOffset : 0;
+        const char *data = static_cast<const char *>(iov[i].iov_base) + skip;
+        size_t len = iov[i].iov_len - skip;
+        if (len < kMinQueuedSegmentBytes)
+        {
+            // 和send的数据一样追加到最后一个段之后
+            if (!hasQueuedSegments())
+            {
+                outputBuffer_.append(data, len);
+            }
+            else
+            {
+                outputQueue_->segments.back().trailer.append(data, len);
+                queuedBytes_ += len;
+            }
+            continue;
+        }
+        OutputSegment segment;
+        if (owned)
+        {
+            segment.data = std::move(owned[i]);
+            segment.offset = skip;
+        }
+        else
+        {
+            segment.data.assign(data, len);
+        }
+        segment.remaining = len;
+        queuedBytes_ += len;
+        mutableOutputQueue().segments.push_back(std::move(segment));
+    }
+    if (!channel_.isWriting())
+    {
+        channel_.enableWriting();
+    }
+}
+
+void TcpConnection::sendFileInLoop(int fd, off_t offset, size_t len)
+{
+    if (state_ == kDisconnected)
+    {
+        LOG_ERROR << "disconnected, give up sending file!";
+        ::close(fd);
+        return;
+    }
+    OutputSegment segment;
+    segment.kind = OutputSegment::kFile;
+    segment.fd = fd;
+    segment.offset = offset;
+    segment.remaining = len;
+    queueSegment(std::move(segment));
+}
+
+void TcpConnection::sendZeroCopyInLoop(std::string &message)
+{
+    if (state_ == kDisconnected)
+    {
+        LOG_ERROR << "disconnected, give up writing!";
+        return;
+    }
+    OutputSegment segment;
+    segment.kind = OutputSegment::kZeroCopy;
+    segment.remaining = message.size();
+    segment.data = std::move(message);
+    queueSegment(std::move(segment));
+}
+
+void TcpConnection::queueSegment(OutputSegment &&segment)
+{
+    size_t oldLen = pendingOutputBytes();
+    queuedBytes_ += segment.remaining;
+    mutableOutputQueue().segments.push_back(std::move(segment));
+    if (oldLen == 0)
+    {
+        // 前面没有待发送的数据，直接发送，发不完的部分等待写事件
+        bool full = false;
+        int savedErrno = 0;
+        writeOutput(SIZE_MAX, &full, &savedErrno);
+        if (pendingOutputBytes() == 0)
+        {
+            if (writeCompleteCallback_)
+            {
+                loop_->queueInLoop(std::bind(writeCompleteCallback_, shared_from_this()));
+            }
+            return;
+        }
+        if (savedErrno == EPIPE || savedErrno == ECONNRESET)
+        {
+            LOG_ERROR << "TcpConnection::queueSegment";
+            return;
+        }
+    }
+
+    size_t newLen = pendingOutputBytes();
+    if (newLen >= highWaterMark_
+            && oldLen < highWaterMark_
+            && highWaterMarkCallback_)
+    {
+        loop_->queueInLoop(std::bind(highWaterMarkCallback_, shared_from_this(), newLen));
+    }
+    if (!channel_.isWriting())
+    {
+        channel_.enableWriting();
+    }
+}
+
+size_t TcpConnection::writeOutput(size_t budget, bool *full, int *savedErrno)
+{
+    size_t total = 0;
+    *full = false;
+    *savedErrno = 0;
+    while (total < budget && pendingOutputBytes() > 0)
+    {
+        if (outputBuffer_.readableBytes() > 0 || outputQueue_->segments.front().kind == OutputSegment::kData)
+        {
+            size_t len = 0;
+            ssize_t n = writeGathered(budget - total, &len);
+            if (n > 0)
+            {
+                total += n;
+                retrieveOutput(n);
+                if (static_cast<size_t>(n) < len)
+                {
+                    *full = true;
+                    break;
+                }
+            }
+            else if (n < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            else
+            {
+                *savedErrno = n < 0 ? errno : 0;
+                *full = true;
+                break;
+            }
+            continue;
+        }
+
+        // 发送队首的文件段或零拷贝段
+        OutputSegment &segment = outputQueue_->segments.front();
+        if (segment.remaining > 0)
+        {
+            size_t len = std::min(segment.remaining, budget - total);
+            ssize_t n = segment.kind == OutputSegment::kFile
+                    ? ::sendfile(channel_.fd(), segment.fd, &segment.offset, len)
+                    : sendZeroCopy(segment, len);
+            if (n > 0)
+            {
+                total += n;
+                segment.remaining -= n;
+                queuedBytes_ -= n;
+                if (static_cast<size_t>(n) < len)
+                {
+                    *full = true;
+                    break;
+                }
+            }
+            else if (n < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EPIPE || errno == ECONNRESET))
+            {
+                *savedErrno = errno;
+                *full = true;
+                break;
+            }
+            else
+            {
+                // 文件被截断（返回0）或读文件出错，丢弃这个段剩下的部分，否则会一直重试
+                LOG_ERROR << "TcpConnection::writeOutput segment fd: " << segment.fd
+                        << " errno: " << (n < 0 ? errno : 0) << " dropped bytes: " << segment.remaining;
+                queuedBytes_ -= segment.remaining;
+                segment.remaining = 0;
+            }
+        }
+        if (segment.remaining == 0)
+        {
+            finishFrontSegment();
+        }
+    }
+    return total;
+}
+
+ssize_t TcpConnection::writeGathered(size_t budget, size_t *len)
+{
+    struct iovec iov[kMaxIovecs];
+    int iovcnt = outputBuffer_.fillIovec(iov, kMaxIovecs, budget);
+    *len = 0;
+    for (int i = 0; i < iovcnt; i++)
+    {
+        *len += iov[i].iov_len;
+    }
+    // outputBuffer_或trailer没有全部加入时，不能越过它加入后面的段
+    bool complete = (*len == outputBuffer_.readableBytes());
+    if (outputQueue_)
+    {
+        for (const OutputSegment &segment: outputQueue_->segments)
+        {
+            if (!complete || segment.kind != OutputSegment::kData || *len >= budget || iovcnt == kMaxIovecs)
+            {
+                break;
+            }
+            iov[iovcnt].iov_base = const_cast<char *>(segment.data.data() + segment.offset);
+            iov[iovcnt].iov_len = segment.remaining;
+            *len += iov[iovcnt++].iov_len;
+            int n = segment.trailer.fillIovec(iov + iovcnt, kMaxIovecs - iovcnt);
+            for (int i = 0; i < n; i++)
+            {
+                *len += iov[iovcnt + i].iov_len;
+            }
+            iovcnt += n;
+            complete = (n == segment.trailer.numBlocks());
+        }
+    }
+    return ::writev(channel_.fd(), iov, iovcnt);
+}
+
+void TcpConnection::retrieveOutput(size_t n)
+{
+    while (n > 0)
+    {
+        size_t readable = outputBuffer_.readableBytes();
+        if (readable > 0)
+        {
+            size_t k = std::min(n, readable);
+            outputBuffer_.retrieve(k);
+            n -= k;
+            continue;
+        }
+        // writeGathered只会越过数据段，这里队首一定是数据段
+        OutputSegment &segment = outputQueue_->segments.front();
+        size_t k = std::min(n, segment.remaining);
+        segment.offset += k;
+        segment.remaining -= k;
+        queuedBytes_ -= k;
+        n -= k;
+        if (segment.remaining == 0)
+        {
+            finishFrontSegment();
+        }
+    }
+}
+
+void TcpConnection::finishFrontSegment()
+{
+    OutputSegment &segment = outputQueue_->segments.front();
+    if (segment.kind == OutputSegment::kFile)
+    {
+        ::close(segment.fd);
+    }
+    else if (segment.zeroCopied && !zeroCopyDone(segment.zeroCopyEnd))
+    {
+        // 内核可能还在引用这些页面，保留到完成通知到达
+        outputQueue_->zeroCopyPinned.push_back(PinnedData{segment.zeroCopyEnd, std::move(segment.data)});
+    }
+    queuedBytes_ -= segment.trailer.readableBytes();
+    outputBuffer_.swap(segment.trailer);
+    outputQueue_->segments.pop_front();
+}
+
+TcpConnection::OutputQueue &TcpConnection::mutableOutputQueue()
+{
+    if (!outputQueue_)
+    {
+        outputQueue_.reset(new OutputQueue);
+    }
+    return *outputQueue_;
+}
+
+ssize_t TcpConnection::sendZeroCopy(OutputSegment &segment, size_t len)
+{
+    const char *data = segment.data.data() + segment.offset;
+    ssize_t n = ::send(channel_.fd(), data, len, MSG_ZEROCOPY);
+    if (n > 0)
+    {
+        // 失败的发送不占用序号
+        segment.zeroCopyEnd = ++outputQueue_->zeroCopySeq;
+        segment.zeroCopied = true;
+        loop_->mutableStats()->recordZeroCopySend();
+    }
+    else if (n < 0 && errno == ENOBUFS)
+    {
+        // 锁定的页面超过了optmem_max或RLIMIT_MEMLOCK，这一部分退回普通send
+        n = ::send(channel_.fd(), data, len, 0);
+    }
+    if (n > 0)
+    {
+        segment.offset += n;
+    }
+    return n;
+}
+
+bool TcpConnection::handleZeroCopyCompletions()
+{
+    bool received = false;
+    for (;;)
+    {
+        char control[128];
+        struct msghdr msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
+        if (::recvmsg(channel_.fd(), &msg, MSG_ERRQUEUE) < 0)
+        {
+            break;  // EAGAIN，错误队列已读空
+        }
+        for (struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg); cmsg != nullptr; cmsg = CMSG_NXTHDR(&msg, cmsg))
+        {
+            if (!((cmsg->cmsg_level == SOL_IP && cmsg->cmsg_type == IP_RECVERR)
+                    || (cmsg->cmsg_level == SOL_IPV6 && cmsg->cmsg_type == IPV6_RECVERR)))
+            {
+                continue;
+            }
+            const struct sock_extended_err *err =
+                    reinterpret_cast<const struct sock_extended_err *>(CMSG_DATA(cmsg));
+            if (err->ee_origin != SO_EE_ORIGIN_ZEROCOPY || err->ee_errno != 0)
+            {
+                continue;
+            }
+            // 序号在[ee_info, ee_data]内的发送都已完成，内核会合并连续的通知
+            uint32_t lo = err->ee_info;
+            uint32_t hi = err->ee_data;
+            loop_->mutableStats()->recordZeroCopyCompletions(hi - lo + 1,
+                    (err->ee_code & SO_EE_CODE_ZEROCOPY_COPIED) != 0);
+            completeZeroCopy(lo, hi);
+            received = true;
+        }
+    }
+    if (received && state_ == kDisconnecting)
+    {
+        shutdownInLoop();
+    }
+    return received;
+}
+
+void TcpConnection::completeZeroCopy(uint32_t lo, uint32_t hi)
+{
+    OutputQueue &queue = mutableOutputQueue();
+    if (lo != queue.zeroCopyDone)
+    {
+        queue.zeroCopyOutOfOrder.emplace_back(lo, hi);
+        return;
+    }
+    queue.zeroCopyDone = hi + 1;
+    // 之前乱序到达的区间可能已经接上
+    for (size_t i = 0; i < queue.zeroCopyOutOfOrder.size(); )
+    {
+        if (queue.zeroCopyOutOfOrder[i].first == queue.zeroCopyDone)
+        {
+            queue.zeroCopyDone = queue.zeroCopyOutOfOrder[i].second + 1;
+            queue.zeroCopyOutOfOrder.erase(queue.zeroCopyOutOfOrder.begin() + i);
+            i = 0;
+        }
+        else
+        {
+            ++i;
+        }
+    }
+    while (!queue.zeroCopyPinned.empty() && zeroCopyDone(queue.zeroCopyPinned.front().end))
+    {
+        queue.zeroCopyPinned.pop_front();
     }
 }
 
@@ -140,9 +790,28 @@ void TcpConnection::shutdown()
 
 void TcpConnection::shutdownInLoop()
 {
-    if (!channel_->isWriting())     // 说明outputBuffer中的数据已经全部发送完成
+    // outputBuffer和各段中的数据已经全部发送完成，零拷贝的数据也都收到了完成通知
+    // 否则关闭之后连接析构，内存可能在数据重传之前就被复用
+    if (pendingOutputBytes() == 0 && !hasPinnedZeroCopy())
+    {
+        socket_.shutdownWrite();   // 关闭写端
+    }
+}
+
+void TcpConnection::forceClose()
+{
+    if (state_ == kConnected || state_ == kDisconnecting)
+    {
+        setState(kDisconnecting);
+        loop_->queueInLoop(std::bind(&TcpConnection::forceCloseInLoop, shared_from_this()));
+    }
+}
+
+void TcpConnection::forceCloseInLoop()
+{
+    if (state_ == kConnected || state_ == kDisconnecting)
     {
-        socket_->shutdownWrite();   // 关闭写端
+        handleClose();
     }
 }
 
@@ -150,8 +819,38 @@ void TcpConnection::shutdownInLoop()
 void TcpConnection::connectEstablished()
 {
     setState(kConnected);
-    channel_->tie(shared_from_this());
-    channel_->enableReading();      // 想Poller注册channel的epollin事件
+    channel_.tie(shared_from_this());
+    if (edgeTriggered_ && !loop_->edgeTriggeredSupported())
+    {
+        // 例如poll(2)后端，退回水平触发，否则一直注册的写事件会让loop空转
+        LOG_ERROR << "TcpConnection [" << name() << "] edge-triggered mode unsupported by poller";
+        setEdgeTriggered(false);
+    }
+    if (edgeTriggered_)
+    {
+        // 边缘触发时读写事件一次注册，之后不再需要epoll_ctl(MOD)
+        channel_.enableAll();
+    }
+    else
+    {
+        channel_.enableReading();  // 想Poller注册channel的epollin事件
+    }
+
+    if (idleTimeout_ > 0.0)
+    {
+        // 时间轮节点只持有弱引用，超时时连接可能已经释放
+        std::weak_ptr<TcpConnection> weakConn(shared_from_this());
+        idleEntry_.setExpireCallback([weakConn]()
+        {
+            TcpConnectionPtr conn = weakConn.lock();
+            if (conn)
+            {
+                LOG_INFO << "TcpConnection [" << conn->name() << "] idle timeout, force close";
+                conn->forceCloseInLoop();
+            }
+        });
+        loop_->timingWheel()->add(&idleEntry_, idleTimeout_);
+    }
 
     // 新连接建立，执行回调
     connectionCallback_(shared_from_this());
@@ -163,26 +862,36 @@ void TcpConnection::connectDestroyed()
     if (state_ == kConnected)
     {
         setState(kDisconnected);
-        channel_->disableAll(); // 把channel的所有感兴趣的事件，从poller中del掉
+        channel_.disableAll(); // 把channel的所有感兴趣的事件，从poller中del掉
         connectionCallback_(shared_from_this());
     }
-    channel_->remove();         // 把channel从poller中删除
+    idleEntry_.remove();
+    channel_.remove();         // 把channel从poller中删除
 }
 
 void TcpConnection::handleRead(Timestamp receiveTime)
 {
+    if (edgeTriggered_)
+    {
+        handleReadEdgeTriggered(receiveTime);
+        return;
+    }
+
+    // 超出预算的数据留在内核中，水平触发下一次poll会再次通知
     int savedErrno = 0;
-    ssize_t n = inputBuffer_.readFd(channel_->fd(), &savedErrno);
+    ssize_t n = inputBuffer_.readFd(channel_.fd(), &savedErrno, readBudget());
     if (n > 0)
     {
+        idleEntry_.touch();
         messageCallback_(shared_from_this(), &inputBuffer_, receiveTime);
     }
     else if (n == 0)
     {
         handleClose();
     }
-    else
+    else if (savedErrno != EAGAIN && savedErrno != EWOULDBLOCK && savedErrno != EINTR)
     {
+        // socket是非阻塞的，虚假唤醒时读到EAGAIN，等下一次可读即可
         errno = savedErrno;
         LOG_ERROR << "TcpConnection::handleRead";
         handleError();
@@ -191,46 +900,172 @@ void TcpConnection::handleRead(Timestamp receiveTime)
 
 void TcpConnection::handleWrite()
 {
-    if (channel_->isWriting())
+    if (edgeTriggered_)
     {
+        handleWriteEdgeTriggered();
+        return;
+    }
+
+    if (channel_.isWriting())
+    {
+        bool full = false;
         int savedErrno = 0;
-        ssize_t n = outputBuffer_.writeFd(channel_->fd(), &savedErrno);
+        size_t n = writeOutput(SIZE_MAX, &full, &savedErrno);
         if (n > 0)
         {
-            outputBuffer_.retrieve(n);
-            if (outputBuffer_.readableBytes() == 0)
+            idleEntry_.touch();
+        }
+        if (pendingOutputBytes() == 0)
+        {
+            channel_.disableWriting();
+            if (writeCompleteCallback_)
             {
-                channel_->disableWriting();
-                if (writeCompleteCallback_)
-                {
-                    // 唤醒loop_对应的thread线程，执行回调
-                    loop_->queueInLoop(std::bind(writeCompleteCallback_, shared_from_this()));
-                }
-                if (state_ == kDisconnecting)
-                {
-                    shutdownInLoop();
-                }
+                // 唤醒loop_对应的thread线程，执行回调
+                loop_->queueInLoop(std::bind(writeCompleteCallback_, shared_from_this()));
+            }
+            if (state_ == kDisconnecting)
+            {
+                shutdownInLoop();
             }
         }
-        else
+        else if (n == 0 && savedErrno != EAGAIN && savedErrno != EWOULDBLOCK)
         {
+            errno = savedErrno;
             LOG_ERROR << "TcpConnection::handleWrite";
         }
     }
     else
     {
-        // LOG_ERROR("TcpConnection fd = %d is down, no more writing\n", channel_->fd());
-        LOG_ERROR << "TcpConnection fd = " << channel_->fd() << " is down, no more writing";
+        // LOG_ERROR("TcpConnection fd = %d is down, no more writing\n", channel_.fd());
+        LOG_ERROR << "TcpConnection fd = " << channel_.fd() << " is down, no more writing";
+    }
+}
+
+size_t TcpConnection::readBudget() const
+{
+    size_t budget = loop_->maxReadBytesPerWakeup();
+    return budget > 0 ? budget : SIZE_MAX;
+}
+
+// 边缘触发时只有新数据到达才会再次通知，必须读到内核缓冲区为空
+// 读到的字节数少于本次最多能读的字节数就说明已经读空，省掉一次返回EAGAIN的read；对端已关闭写端时除外
+void TcpConnection::handleReadEdgeTriggered(Timestamp receiveTime)
+{
+    if (state_ == kDisconnected)
+    {
+        return;
+    }
+
+    const size_t budget = readBudget();
+    int savedErrno = 0;
+    size_t total = 0;
+    bool drained = false;
+    bool peerClosed = false;
+    bool error = false;
+    while (total < budget)
+    {
+        size_t maxBytes = std::min(inputBuffer_.maxReadBytes(), budget - total);
+        ssize_t n = inputBuffer_.readFd(channel_.fd(), &savedErrno, maxBytes);
+        if (n > 0)
+        {
+            total += n;
+            // 短读说明内核缓冲区已空，除非对端的FIN排在数据之后：它不会再触发新的通知，
+            // 要再读一次拿到0才能发现连接关闭
+            if (static_cast<size_t>(n) < maxBytes && !channel_.peerClosedReported())
+            {
+                drained = true;
+                break;
+            }
+        }
+        else if (n == 0)
+        {
+            peerClosed = true;
+            break;
+        }
+        else if (savedErrno == EINTR)
+        {
+            continue;
+        }
+        else
+        {
+            drained = true;
+            error = (savedErrno != EAGAIN && savedErrno != EWOULDBLOCK);
+            break;
+        }
+    }
+
+    if (total > 0)
+    {
+        idleEntry_.touch();
+        messageCallback_(shared_from_this(), &inputBuffer_, receiveTime);
+    }
+
+    if (peerClosed)
+    {
+        handleClose();
+    }
+    else if (error)
+    {
+        errno = savedErrno;
+        LOG_ERROR << "TcpConnection::handleReadEdgeTriggered";
+        handleError();
+    }
+    else if (!drained)
+    {
+        // 预算用完但还有数据，不会再有新的通知，放到回调队列中继续读
+        loop_->queueInLoop(std::bind(&TcpConnection::handleReadEdgeTriggered,
+                shared_from_this(), receiveTime));
+    }
+}
+
+void TcpConnection::handleWriteEdgeTriggered()
+{
+    // 读事件触发时也会带上EPOLLOUT，此时可能没有待发送的数据
+    if (state_ == kDisconnected || pendingOutputBytes() == 0)
+    {
+        return;
+    }
+
+    int savedErrno = 0;
+    bool full = false;      // 内核发送缓冲区已满，会有下一次EPOLLOUT
+    size_t total = writeOutput(kEdgeTriggeredWriteBudget, &full, &savedErrno);
+    if (full && savedErrno != 0 && savedErrno != EAGAIN && savedErrno != EWOULDBLOCK)
+    {
+        errno = savedErrno;
+        LOG_ERROR << "TcpConnection::handleWriteEdgeTriggered";
+    }
+
+    if (total > 0)
+    {
+        idleEntry_.touch();
+    }
+
+    if (pendingOutputBytes() == 0)
+    {
+        if (writeCompleteCallback_)
+        {
+            loop_->queueInLoop(std::bind(writeCompleteCallback_, shared_from_this()));
+        }
+        if (state_ == kDisconnecting)
+        {
+            shutdownInLoop();
+        }
+    }
+    else if (!full)
+    {
+        // 预算用完，放到回调队列中继续写
+        loop_->queueInLoop(std::bind(&TcpConnection::handleWriteEdgeTriggered, shared_from_this()));
     }
 }
 
 void TcpConnection::handleClose()
 {
-    // LOG_INFO("fd = %d state = %d\n", channel_->fd(), (int)state_);
-    LOG_INFO << "fd = " << channel_->fd() 
+    // LOG_INFO("fd = %d state = %d\n", channel_.fd(), (int)state_);
+    LOG_DEBUG << "fd = " << channel_.fd() 
             << " state = " << (int)state_;
     setState(kDisconnected);
-    channel_->disableAll();
+    channel_.disableAll();
+    idleEntry_.remove();
 
     TcpConnectionPtr connPtr(shared_from_this());
     connectionCallback_(connPtr);   // 执行连接关闭的回调
@@ -239,10 +1074,16 @@ void TcpConnection::handleClose()
 
 void TcpConnection::handleError()
 {
+    // 零拷贝的完成通知也以EPOLLERR报告，不是连接出错；不读空错误队列的话水平触发会一直通知
+    if (zeroCopyThreshold_ > 0 && handleZeroCopyCompletions())
+    {
+        return;
+    }
+
     int optval;
     socklen_t optlen = sizeof(optval);
     int err = 0;
-    if (::getsockopt(channel_->fd(), SOL_SOCKET, SO_ERROR, &optval, &optlen) < 0)
+    if (::getsockopt(channel_.fd(), SOL_SOCKET, SO_ERROR, &optval, &optlen) < 0)
     {
         err = errno;
     }
@@ -251,6 +1092,6 @@ void TcpConnection::handleError()
         err = optval;
     }
     // LOG_ERROR("TcpConnection::handleError name: %s - SO_ERROR: %d\n", name_.c_str(), err);
-    LOG_ERROR << "TcpConnection::handleError name: " << name_
+    LOG_ERROR << "TcpConnection::handleError name: " << name()
             << " - SO_ERROR: " << err;
 }
\ No newline at end of file
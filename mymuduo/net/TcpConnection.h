@@ -3,8 +3,13 @@
 #include <memory>
 #include <string>
 #include <atomic>
+#include <deque>
+#include <vector>
+#include <utility>
+#include <stdint.h>
 #include <sys/types.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <string.h>
 #include <netinet/tcp.h>
 #include <sys/socket.h>
@@ -12,11 +17,13 @@
 #include "InetAddress.h"
 #include "Callbacks.h"
 #include "Buffer.h"
+#include "ChainBuffer.h"
 #include "Timestamp.h"
+#include "TimingWheel.h"
+#include "Socket.h"
+#include "Channel.h"
 
-class Channel;
 class EventLoop;
-class Socket;
 
 // 对channel的一些操作进行封装，如读写channel，Buffer也用在这里
 // 为channel设置回调函数，读、写、关闭、错误回调
@@ -24,24 +31,68 @@ class Socket;
 class TcpConnection: noncopyable, public std::enable_shared_from_this<TcpConnection>
 {
 public:
+    using Id = uint64_t;
+
+    // 连接名在需要时由namePrefix和id拼出，连接本身不保存名字
+    // namePrefix由同一个服务器的所有连接共享，例如"EchoServer-127.0.0.1:8000"
     TcpConnection(EventLoop *loop,
-            const std::string &nameArg,
+            Id id,
+            std::shared_ptr<const std::string> namePrefix,
             int sockfd,
             const InetAddress &localAddr,
             const InetAddress &peerAddr);
     ~TcpConnection();
 
     EventLoop *getLoop() const { return loop_; }
-    const std::string &name() const { return name_; }
+    // 在所属服务器内唯一的连接id，见SlotTable
+    Id id() const { return id_; }
+    // "前缀#表编号.槽位.代数"，每次调用都重新格式化，只用于日志等非热路径
+    std::string name() const;
+    // id的可读形式"#表编号.槽位.代数"
+    static std::string idString(Id id);
     const InetAddress &localAddress() const { return localAddr_; }
     const InetAddress &peerAddress() const { return peerAddr_; }
 
     bool connected() const { return state_ == kConnected; }
 
-    // 发送数据
+    // 发送数据，可在任意线程调用
+    // 在其他线程调用时会拷贝一份数据交给loop线程，传入右值则直接移动，不分配内存
     void send(const std::string &buf);
+    // 开启零拷贝（见setZeroCopyThreshold）且buf不小于阈值时，用MSG_ZEROCOPY发送，
+    // buf的内存一直保留到内核通知发送完成
+    void send(std::string &&buf);
+    // 一次发送多段数据，例如分开存放的协议头和消息体，不需要先拼接，可在任意线程调用
+    // 没有待发送数据时直接writev；发不完的段逐段排队，不拼接到一个缓冲区中（较小的段除外）
+    // 在其他线程调用时每段拷贝一份交给loop线程；传入string则直接移动
+    void sendv(const struct iovec *iov, int iovcnt);
+    void sendv(std::vector<std::string> &&segments);
+    // 用sendfile(2)发送文件fd中[offset, offset + len)的内容，数据不经过用户态，可在任意线程调用
+    // 文件段排在已经send但还没发出的数据之后，之后send的数据也排在它之后，顺序与调用顺序一致
+    // 内部会dup一份fd，调用返回后可以直接关闭fd；fd必须是普通文件
+    // 未发出的文件字节计入高水位，全部发完后同样触发写完成回调
+    void sendFile(int fd, off_t offset, size_t len);
     // 关闭连接
     void shutdown();
+    // 强制关闭连接，不等待发送缓冲区中的数据发完
+    void forceClose();
+
+    // 空闲超时时间，单位秒，超过该时间没有读写则强制关闭，0表示不检测
+    // 需要在connectEstablished之前设置
+    void setIdleTimeout(double seconds) { idleTimeout_ = seconds; }
+
+    // 设置socket的SO_BUSY_POLL
+    void setBusyPoll(int microSeconds);
+
+    // 边缘触发模式，需要在connectEstablished之前设置
+    // 该模式下读写事件只注册一次，读写都进行到EAGAIN或用完单次预算为止
+    void setEdgeTriggered(bool on);
+
+    // 右值send的数据不小于bytes字节时走MSG_ZEROCOPY，0表示关闭，需要在connectEstablished之前设置
+    // 内核直接从用户内存DMA，省掉拷贝到socket缓冲区的开销，但每次send要锁定页面，
+    // 完成后还要从错误队列读取通知，只适合较大的消息（内核文档建议10KB以上）
+    // 对端在本机（loopback、unix域）时内核仍会拷贝，见EventLoopStats::Snapshot::zeroCopyCopied
+    // 小于4096的非0值按4096处理
+    void setZeroCopyThreshold(size_t bytes);
 
     void setConnectionCallback(const ConnectionCallback &cb) { connectionCallback_ = cb; }
     void setMessageCallback(const MessageCallback &cb) { messageCallback_ = cb; }
@@ -64,21 +115,61 @@ private:
     void handleWrite();
     void handleClose();
     void handleError();
+    // 边缘触发模式下的读写处理
+    void handleReadEdgeTriggered(Timestamp receiveTime);
+    void handleWriteEdgeTriggered();
+    // 每次读事件最多读取的字节数，取自所属loop的配置
+    size_t readBudget() const;
 
     void sendInLoop(const void *message, size_t len);
+    void sendFileInLoop(int fd, off_t offset, size_t len);
+    void sendZeroCopyInLoop(std::string &message);
+    // owned不为空时iov[i]指向owned[i]的内容，未发出的段直接移入队列，否则拷贝
+    void sendvInLoop(const struct iovec *iov, int iovcnt, std::string *owned);
+    void sendStringsInLoop(std::vector<std::string> &segments);
+    struct OutputSegment;
+    struct OutputQueue;
+    bool hasQueuedSegments() const { return outputQueue_ && !outputQueue_->segments.empty(); }
+    // 第一次调用时分配outputQueue_
+    OutputQueue &mutableOutputQueue();
+    // 把文件段或零拷贝段排到发送队列末尾，前面没有待发送数据时立即开始发送
+    void queueSegment(OutputSegment &&segment);
+    // 按顺序发送outputBuffer_和排队的段，最多发送约budget字节，返回发送的字节数
+    // 内核发送缓冲区已满或出错时*full为true，出错时*savedErrno为错误码
+    size_t writeOutput(size_t budget, bool *full, int *savedErrno);
+    // 把outputBuffer_的各块和之后连续的数据段（及其trailer）用一次writev发出，最多IOV_MAX个iovec
+    ssize_t writeGathered(size_t budget, size_t *len);
+    // 从outputBuffer_和队首的数据段中移除已发出的n字节
+    void retrieveOutput(size_t n);
+    // 队首的段已发完：关闭文件、保留零拷贝数据，trailer换入outputBuffer_
+    void finishFrontSegment();
+    // 发送零拷贝段的一部分，内核拒绝锁定页面（ENOBUFS）时退回普通send
+    ssize_t sendZeroCopy(OutputSegment &segment, size_t len);
+    // 读取错误队列中的零拷贝完成通知，释放已完成的数据，没有读到通知时返回false
+    bool handleZeroCopyCompletions();
+    void completeZeroCopy(uint32_t lo, uint32_t hi);
+    bool zeroCopyDone(uint32_t end) const { return static_cast<int32_t>(outputQueue_->zeroCopyDone - end) >= 0; }
+    bool hasPinnedZeroCopy() const { return outputQueue_ && !outputQueue_->zeroCopyPinned.empty(); }
+    // 还没有发出的字节数，包括排队的段
+    size_t pendingOutputBytes() const { return outputBuffer_.readableBytes() + queuedBytes_; }
+    void sendStringInLoop(const std::string &message);
     void shutdownInLoop();
+    void forceCloseInLoop();
 
 private:
     enum StateE {kDisconnected, kConnecting, kConnected, kDisconnecting};
     void setState(StateE state) { state_ = state; }
     
     EventLoop *loop_;
-    const std::string name_;
+    const Id id_;
+    const std::shared_ptr<const std::string> namePrefix_;
     std::atomic_int state_;
     bool reading_;
+    bool edgeTriggered_;
 
-    std::unique_ptr<Socket> socket_;
-    std::unique_ptr<Channel> channel_;
+    // 直接内嵌，和连接对象在同一次分配中
+    Socket socket_;
+    Channel channel_;
 
     const InetAddress localAddr_;
     const InetAddress peerAddr_;
@@ -91,5 +182,44 @@ private:
     size_t highWaterMark_;
 
     Buffer inputBuffer_;    // 接受数据缓冲区
-    Buffer outputBuffer_;   // 发送数据缓冲区
+    // 发送数据缓冲区，积压时只挂新块，不像Buffer那样扩容或搬移已有数据
+    ChainBuffer outputBuffer_;
+
+    // sendFile的文件段、零拷贝send的数据和sendv排队的数据段，队首的段在outputBuffer_发完之后发送
+    struct OutputSegment
+    {
+        enum Kind {kData, kFile, kZeroCopy};
+        Kind kind = kData;
+        int fd = -1;        // 文件段：dup得到的fd，发完或连接析构时关闭
+        off_t offset = 0;   // 文件段：下一个要发送的文件偏移；其他：data中已发出的字节数
+        size_t remaining = 0;
+        std::string data;
+        uint32_t zeroCopyEnd = 0;   // 零拷贝段：最后一次MSG_ZEROCOPY发送的序号加1
+        bool zeroCopied = false;    // 零拷贝段：是否有部分数据以MSG_ZEROCOPY发出
+        ChainBuffer trailer;    // 段之后send的数据，段发完后换入outputBuffer_
+    };
+    // 已经全部交给内核、等待完成通知的零拷贝数据，按发送顺序排列
+    struct PinnedData
+    {
+        uint32_t end;       // 序号小于end的发送全部完成后释放
+        std::string data;
+    };
+    // 排队的段和零拷贝的完成状态，只有用过sendv、sendFile或零拷贝的连接才需要，第一次排队时分配
+    // 不内嵌在连接中，TcpConnection和shared_ptr控制块才能放进BlockPool的最大一档
+    struct OutputQueue
+    {
+        std::deque<OutputSegment> segments;
+        std::deque<PinnedData> zeroCopyPinned;
+        // 序号与内核为每个socket维护的32位计数一致，每次成功的MSG_ZEROCOPY发送加1，比较时按回绕处理
+        uint32_t zeroCopySeq = 0;   // 下一次MSG_ZEROCOPY发送的序号
+        uint32_t zeroCopyDone = 0;  // 序号小于它的发送都已完成
+        // 乱序到达的完成区间[lo, hi]，等前面的区间到达后合并进zeroCopyDone
+        std::vector<std::pair<uint32_t, uint32_t>> zeroCopyOutOfOrder;
+    };
+    std::unique_ptr<OutputQueue> outputQueue_;
+    size_t queuedBytes_;    // 排队的各段和trailer未发出的字节数
+    size_t zeroCopyThreshold_;
+
+    double idleTimeout_;
+    TimingWheel::Entry idleEntry_;  // 在所属loop时间轮中的节点
 };
\ No newline at end of file
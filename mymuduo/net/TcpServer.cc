@@ -2,8 +2,15 @@
 #include "Logger.h"
 #include "functional"
 #include "TcpConnection.h"
+#include "CountDownLatch.h"
 #include <string.h>
 
+// allocate_shared把控制块（虚表指针、两个引用计数、一份分配器）和连接放在同一块内存中，
+// 超过BlockPool的最大一档时每个连接都会退回operator new
+static_assert(sizeof(TcpConnection) + sizeof(void *) + 2 * sizeof(int) + sizeof(PoolAllocator<TcpConnection>)
+        <= BlockPool::kSizeClassBytes * BlockPool::kNumSizeClasses,
+        "pooled TcpConnection allocation exceeds the largest BlockPool size class");
+
 // #define CHECK_NOTNULL(x) \
 
 static EventLoop *CheckLoopNotNull(EventLoop *loop)
@@ -22,14 +29,25 @@ TcpServer::TcpServer(EventLoop *loop,
         const std::string &nameArg,
         Option option)
         : loop_(CheckLoopNotNull(loop))
+        , listenAddr_(listenAddr)
         , ipPort_(listenAddr.toIpPort())
         , name_(nameArg)
+        , connNamePrefix_(std::make_shared<const std::string>(nameArg + "-" + ipPort_))
+        , reusePort_(option == kReusePort)
         , acceptor_(new Acceptor(loop, listenAddr, option == kReusePort))
         , threadPool_(new EventLoopThreadPool(loop, name_))
         , connectionCallback_()
         , messageCallback_()
-        , nextConnId_(1)
         , started_(0)
+        , idleTimeout_(0.0)
+        , edgeTriggered_(false)
+        , socketBusyPollUs_(0)
+        , lazyWriteDisarm_(0)
+        , cpuSteering_(false)
+        , listenBacklog_(Socket::kDefaultBacklog)
+        , maxAcceptsPerWakeup_(Acceptor::kDefaultMaxAcceptsPerWakeup)
+        , zeroCopyThreshold_(0)
+        , alive_(std::make_shared<bool>(true))
 {
     acceptor_->setNewConnectionCallback(std::bind(&TcpServer::newConnection, this, 
             std::placeholders::_1, std::placeholders::_2));
@@ -37,13 +55,59 @@ TcpServer::TcpServer(EventLoop *loop,
 
 TcpServer::~TcpServer()
 {
-    for (auto &item: connections_)
+    // 已接受的连接可能还在subloop中创建，等这些任务执行完，它们创建的连接都放进了pendingConnections_，
+    // 之后不会再有引用this的创建任务
+    const bool handOff = started_ > 0 && acceptor_;
+    if (handOff)
+    {
+        waitForLoops();
+    }
+    addPendingConnections();
+
+    connections_.forEach([](TcpConnection::Id, TcpConnectionPtr &item)
+    {
+        // 槽位可能已预留但连接还没有加入
+        if (item)
+        {
+            TcpConnectionPtr conn(item);
+            item.reset();
+
+            // 销毁连接
+            conn->getLoop()->runInLoop(std::bind(&TcpConnection::connectDestroyed, conn));
+        }
+    });
+    // 等连接在各自的subloop中销毁完，之后不会再有连接调用引用this的关闭回调
+    if (handOff)
     {
-        TcpConnectionPtr conn(item.second);
-        item.second.reset();
+        waitForLoops();
+    }
 
-        // 销毁连接
-        conn->getLoop()->runInLoop(std::bind(&TcpConnection::connectDestroyed, conn));
+    // 各subloop的监听socket和连接只能在所属loop中销毁，等它们都完成
+    for (auto &local: loopAcceptors_)
+    {
+        CountDownLatch latch(1);
+        LoopAcceptor *ptr = local.get();
+        local->loop->runInLoop([ptr, &latch]()
+        {
+            ptr->acceptor.reset();
+            ptr->connections.forEach([](TcpConnection::Id, TcpConnectionPtr &conn)
+            {
+                conn->connectDestroyed();
+            });
+            ptr->connections.clear();
+            latch.countDown();
+        });
+        latch.wait();
+    }
+}
+
+void TcpServer::waitForLoops()
+{
+    for (EventLoop *ioLoop: threadPool_->getAllLoops())
+    {
+        CountDownLatch latch(1);
+        ioLoop->runInLoop([&latch]() { latch.countDown(); });
+        latch.wait();
     }
 }
 
@@ -52,31 +116,98 @@ void TcpServer::setThreadNum(int numThreads)
     threadPool_->setThreadNum(numThreads);
 }
 
+void TcpServer::setThreadAffinity(EventLoopThreadPool::AffinityPolicy policy, const std::vector<int> &ids)
+{
+    threadPool_->setAffinity(policy, ids);
+}
+
+void TcpServer::setLoadBalance(EventLoopThreadPool::LoadBalance policy)
+{
+    threadPool_->setLoadBalance(policy);
+}
+
+void TcpServer::setLoopChooser(EventLoopThreadPool::LoopChooser chooser)
+{
+    threadPool_->setLoopChooser(std::move(chooser));
+}
+
+void TcpServer::setBusyPoll(int64_t loopBudgetUs, int socketBusyPollUs)
+{
+    threadPool_->setBusyPollBudget(loopBudgetUs);
+    socketBusyPollUs_ = socketBusyPollUs;
+}
+
 void TcpServer::start()
 {
     if (started_++ == 0)    // 防止一个TcpServer对象被start多次
     {
         threadPool_->start(threadInitCallback_);    // 启动底层loop线程池
-        loop_->runInLoop(std::bind(&Acceptor::listen, acceptor_.get()));
+        if (lazyWriteDisarm_ > 0)
+        {
+            for (EventLoop *loop: threadPool_->getAllLoops())
+            {
+                loop->setLazyWriteDisarm(lazyWriteDisarm_);
+            }
+        }
+        if (reusePort_ && threadPool_->numThreads() > 0)
+        {
+            startLoopAcceptors();
+        }
+        else
+        {
+            configureAcceptor(acceptor_.get());
+            loop_->runInLoop(std::bind(&Acceptor::listen, acceptor_.get()));
+        }
     }
 }
 
-// 有一个新的客户端连接，acceptor会执行这个回调操作
-void TcpServer::newConnection(int sockfd, const InetAddress &peerAddr)
+void TcpServer::startLoopAcceptors()
 {
-    // 轮询算法，选择一个subloop管理channel
-    EventLoop *ioLoop = threadPool_->getNextLoop();
-    char buf[64] = {0};
-    snprintf(buf, sizeof(buf), "-%s#%d", ipPort_.c_str(), nextConnId_);
-    ++nextConnId_;
-    std::string connName = name_ + buf;
+    // baseLoop不再接受连接
+    acceptor_.reset();
 
-    // LOG_INFO("TcpServer::newConnection [%s] - new connection [%s] from %s\n",
-    //         name_.c_str(), connName.c_str(), peerAddr.toIpPort().c_str());
-    LOG_INFO << "TcpServer::newConnection [" << name_ 
-            << "] - new connection [" << connName 
-            << "] from " << peerAddr.toIpPort();
-    // 通过sockfd获取其绑定的本机的ip地址和端口信息
+    // 连接由内核在各subloop的监听socket之间分配，baseLoop的分配策略用不上
+    if (threadPool_->hasLoopChooser() || threadPool_->loadBalance() != EventLoopThreadPool::kRoundRobin)
+    {
+        LOG_ERROR << "TcpServer::start [" << name_ << "] - kReusePort ignores setLoadBalance/setLoopChooser,"
+                << " connections are distributed by the kernel";
+    }
+
+    std::vector<EventLoop *> loops = threadPool_->getAllLoops();
+    for (EventLoop *ioLoop: loops)
+    {
+        LoopAcceptor *local = new LoopAcceptor(ioLoop, static_cast<uint16_t>(loopAcceptors_.size() + 1));
+        local->acceptor.reset(new Acceptor(ioLoop, listenAddr_, true));
+        local->acceptor->setNewConnectionCallback(std::bind(&TcpServer::newLoopConnection, this,
+                local, std::placeholders::_1, std::placeholders::_2));
+        configureAcceptor(local->acceptor.get());
+        loopAcceptors_.push_back(std::unique_ptr<LoopAcceptor>(local));
+
+        // 依次listen，socket在reuseport组中的序号与loop的序号一致，CPU分配程序依赖这个顺序
+        CountDownLatch latch(1);
+        ioLoop->runInLoop([local, &latch]()
+        {
+            local->acceptor->listen();
+            latch.countDown();
+        });
+        latch.wait();
+    }
+
+    if (cpuSteering_)
+    {
+        loopAcceptors_.front()->acceptor->setReusePortCpuSteering(static_cast<int>(loops.size()));
+    }
+}
+
+void TcpServer::configureAcceptor(Acceptor *acceptor)
+{
+    acceptor->setBacklog(listenBacklog_);
+    acceptor->setMaxAcceptsPerWakeup(maxAcceptsPerWakeup_);
+}
+
+// 通过sockfd获取其绑定的本机的ip地址和端口信息
+static InetAddress getLocalAddr(int sockfd)
+{
     sockaddr_in local;
     ::bzero(&local, sizeof(local));
     socklen_t addrlen = sizeof(local);
@@ -84,26 +215,121 @@ void TcpServer::newConnection(int sockfd, const InetAddress &peerAddr)
     {
         LOG_ERROR << "sockets::getLocalAddr";
     }
-    InetAddress localAddr(local);
+    return InetAddress(local);
+}
+
+// 有一个新的客户端连接，acceptor会执行这个回调操作
+void TcpServer::newConnection(int sockfd, const InetAddress &peerAddr)
+{
+    // 按分配策略选择一个subloop管理channel，默认轮询
+    EventLoop *ioLoop = threadPool_->getNextLoop(peerAddr);
+    ioLoop->adjustConnectionCount(1);
+    // 先在baseLoop中预留槽位得到连接id，连接对象创建后由addPendingConnections填入
+    TcpConnection::Id id = connections_.insert(TcpConnectionPtr());
+
+    // LOG_INFO("TcpServer::newConnection [%s] - new connection [%s] from %s\n",
+    //         name_.c_str(), connName.c_str(), peerAddr.toIpPort().c_str());
+    LOG_INFO << "TcpServer::newConnection [" << name_ 
+            << "] - new connection [" << *connNamePrefix_ << TcpConnection::idString(id)
+            << "] from " << peerAddr.toIpPort();
 
+    // 连接对象在ioLoop线程中创建，TcpConnection及其Buffer、Channel由该线程分配，
+    // 线程绑核时这些内存都在loop所在的NUMA节点上
+    // lambda比std::bind小，能放进Functor的内联存储，投递时不分配内存
+    InetAddress localAddr(getLocalAddr(sockfd));
+    ioLoop->runInLoop([this, ioLoop, sockfd, id, localAddr, peerAddr]()
+    {
+        newConnectionInLoop(ioLoop, sockfd, id, localAddr, peerAddr);
+    });
+}
+
+TcpConnectionPtr TcpServer::createConnection(EventLoop *ioLoop, int sockfd, TcpConnection::Id id,
+        const InetAddress &localAddr, const InetAddress &peerAddr)
+{
     // 根据连接成功的sockfd，创建TcpConnection连接对象
-    TcpConnectionPtr conn(new TcpConnection(ioLoop, connName, sockfd, localAddr, peerAddr));
-    connections_[connName] = conn;
+    // 连接对象（内嵌Socket、Channel）和shared_ptr控制块一起从ioLoop的内存池分配，
+    // 本函数总在ioLoop线程中执行，连接反复建立和关闭时不调用malloc
+    TcpConnectionPtr conn(std::allocate_shared<TcpConnection>(PoolAllocator<TcpConnection>(ioLoop->blockPool()),
+            ioLoop, id, connNamePrefix_, sockfd, localAddr, peerAddr));
 
     // 下面的回调都是用户设置给TcpServer => TcpConnection => Channel => Poller => notify channel调用回调
     conn->setConnectionCallback(connectionCallback_);
     conn->setMessageCallback(messageCallback_);
     conn->setWriteCompleteCallback(writeCompleteCallback_);
+    conn->setIdleTimeout(idleTimeout_);
+    conn->setEdgeTriggered(edgeTriggered_);
+    if (socketBusyPollUs_ > 0)
+    {
+        conn->setBusyPoll(socketBusyPollUs_);
+    }
+    if (zeroCopyThreshold_ > 0)
+    {
+        conn->setZeroCopyThreshold(zeroCopyThreshold_);
+    }
+    return conn;
+}
+
+void TcpServer::newConnectionInLoop(EventLoop *ioLoop, int sockfd, TcpConnection::Id id,
+        const InetAddress &localAddr, const InetAddress &peerAddr)
+{
+    TcpConnectionPtr conn(createConnection(ioLoop, sockfd, id, localAddr, peerAddr));
 
     // 设置关闭连接回调
-    conn->setCloseCallback(std::bind(&TcpServer::removeConnection, this, std::placeholders::_1));
-    
-    ioLoop->runInLoop(std::bind(&TcpConnection::connectEstablished, conn));
+    // 只捕获指针的lambda放得进std::function的内部存储，bind成员函数则需要分配内存
+    conn->setCloseCallback([this](const TcpConnectionPtr &c) { removeConnection(c); });
+
+    // connections_只在baseLoop中访问，这里把连接交给pendingConnections_，由baseLoop成批取走
+    // 只有列表由空变为非空时才投递一次，连接风暴时一次投递处理一批连接
+    bool first = false;
+    {
+        std::unique_lock<std::mutex> lock(pendingMutex_);
+        first = pendingConnections_.empty();
+        pendingConnections_.push_back(conn);
+    }
+    if (first)
+    {
+        // 和removeConnection一样，TcpServer析构后不再访问this，析构函数会自己取走剩下的连接
+        std::weak_ptr<bool> alive(alive_);
+        loop_->queueInLoop([this, alive]()
+        {
+            if (!alive.expired())
+            {
+                addPendingConnections();
+            }
+        });
+    }
+    conn->connectEstablished();
+}
+
+void TcpServer::addPendingConnections()
+{
+    std::vector<TcpConnectionPtr> pending;
+    {
+        std::unique_lock<std::mutex> lock(pendingMutex_);
+        pending.swap(pendingConnections_);
+    }
+    for (TcpConnectionPtr &conn: pending)
+    {
+        TcpConnectionPtr *slot = connections_.find(conn->id());
+        if (slot)
+        {
+            *slot = std::move(conn);
+        }
+    }
 }
 
 void TcpServer::removeConnection(const TcpConnectionPtr &conn)
 {
-    loop_->runInLoop(std::bind(&TcpServer::removeConnectionInLoop, this, conn));
+    // 投递之后TcpServer可能先析构，这时连接已由析构函数销毁，什么都不用做
+    // 析构和这个任务都在baseLoop中执行，检查alive_之后this不会失效
+    std::weak_ptr<bool> alive(alive_);
+    loop_->runInLoop([this, alive, conn]()
+    {
+        if (!alive.expired())
+        {
+            removeConnectionInLoop(conn);
+        }
+    });
 }
 
 void TcpServer::removeConnectionInLoop(const TcpConnectionPtr &conn)
@@ -114,7 +340,35 @@ void TcpServer::removeConnectionInLoop(const TcpConnectionPtr &conn)
     LOG_INFO << "TcpServer::removeConnectionInLoop [" << name_ 
             << "] - connection " << conn->name();
 
-    connections_.erase(conn->name());
+    // 批量加入的任务可能由其他subloop投递、排在本任务之后，连接还在pendingConnections_中，先取走再移除
+    addPendingConnections();
+    connections_.erase(conn->id());
     EventLoop *ioLoop = conn->getLoop();
+    ioLoop->adjustConnectionCount(-1);
     ioLoop->queueInLoop(std::bind(&TcpConnection::connectDestroyed, conn));
-}
\ No newline at end of file
+}
+// kReusePort模式下subloop自己accept到新连接，在本线程中创建、保存连接
+void TcpServer::newLoopConnection(LoopAcceptor *local, int sockfd, const InetAddress &peerAddr)
+{
+    local->loop->adjustConnectionCount(1);
+    TcpConnection::Id id = local->connections.insert(TcpConnectionPtr());
+    LOG_INFO << "TcpServer::newLoopConnection [" << name_
+            << "] - new connection [" << *connNamePrefix_ << TcpConnection::idString(id)
+            << "] from " << peerAddr.toIpPort();
+
+    TcpConnectionPtr conn(createConnection(local->loop, sockfd, id, getLocalAddr(sockfd), peerAddr));
+    conn->setCloseCallback([this, local](const TcpConnectionPtr &c) { removeLoopConnection(local, c); });
+    *local->connections.find(id) = conn;
+    conn->connectEstablished();
+}
+
+// 关闭回调在连接所属的loop中执行，也就是local所属的loop
+void TcpServer::removeLoopConnection(LoopAcceptor *local, const TcpConnectionPtr &conn)
+{
+    LOG_INFO << "TcpServer::removeLoopConnection [" << name_
+            << "] - connection " << conn->name();
+
+    local->connections.erase(conn->id());
+    local->loop->adjustConnectionCount(-1);
+    local->loop->queueInLoop(std::bind(&TcpConnection::connectDestroyed, conn));
+}
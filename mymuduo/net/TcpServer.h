@@ -2,8 +2,9 @@
 #include <functional>
 #include <string>
 #include <memory>
+#include <vector>
 #include <atomic>
-#include <unordered_map>
+#include <mutex>
 #include "EventLoop.h"
 #include "Acceptor.h"
 #include "InetAddress.h"
@@ -12,6 +13,7 @@
 #include "Callbacks.h"
 #include "TcpConnection.h"
 #include "Buffer.h"
+#include "SlotTable.h"
 
 // 对外服务器编程使用的类
 // 主要对mainloop的一些操作进行封装，mainloop是监听新连接事件
@@ -20,6 +22,9 @@ class TcpServer: noncopyable
 public:
     using ThreadInitCallback = std::function<void(EventLoop *)>;
 
+    // kReusePort：有subloop时每个subloop各自创建一个SO_REUSEPORT的监听socket并直接accept，
+    // 由内核在这些socket之间分配连接，新连接不再经过baseLoop转交；
+    // 没有subloop时与kNoReusePort相同，只是监听socket设置了SO_REUSEPORT
     enum Option
     {
         kNoReusePort,
@@ -40,21 +45,94 @@ public:
     // 设置底层subloop的个数
     void setThreadNum(int numThreads);
 
+    // 连接空闲超过seconds秒则强制关闭，0表示不检测，需要在start之前设置
+    // 空闲检测使用每个subloop的时间轮，读写时只更新时间轮节点，不为每个连接创建定时器
+    void setIdleTimeout(double seconds) { idleTimeout_ = seconds; }
+
+    // subloop线程的绑核策略，见EventLoopThreadPool::AffinityPolicy，需要在start之前设置
+    void setThreadAffinity(EventLoopThreadPool::AffinityPolicy policy,
+            const std::vector<int> &ids = std::vector<int>());
+
+    // 新连接分配到subloop的策略，见EventLoopThreadPool::LoadBalance，需要在start之前设置
+    // 与kReusePort互斥：kReusePort模式下有subloop时由内核分配连接，这两个设置不生效，start时会打印警告
+    void setLoadBalance(EventLoopThreadPool::LoadBalance policy);
+    // 自定义分配策略，优先于setLoadBalance，需要在start之前设置，同样不能与kReusePort一起使用
+    void setLoopChooser(EventLoopThreadPool::LoopChooser chooser);
+
+    // subloop的忙轮询预算（微秒），以及新连接socket的SO_BUSY_POLL（微秒），0表示关闭
+    // 用于延迟敏感的服务，每个subloop会在空闲时占满一个CPU核
+    void setBusyPoll(int64_t loopBudgetUs, int socketBusyPollUs = 0);
+
+    // 新连接使用边缘触发模式，减少poll唤醒和epoll_ctl(MOD)，需要在start之前设置
+    void setEdgeTriggered(bool on) { edgeTriggered_ = on; }
+
+    // 连接取消关注写事件后，EPOLLOUT最多保留iterations轮poll，见EventLoop::setLazyWriteDisarm
+    // 需要在start之前设置
+    void setLazyWriteDisarm(int iterations) { lazyWriteDisarm_ = iterations; }
+
+    // kReusePort模式下让内核按处理SYN的CPU选择监听socket：CPU c上的连接交给第c % n个subloop
+    // 配合setThreadAffinity(kCpuList, {0, 1, ..., n-1})时，连接由收到它的CPU上的loop处理
+    // 需要在start之前设置，内核不支持时退回默认的哈希分配
+    void setReusePortCpuSteering(bool on) { cpuSteering_ = on; }
+
+    // 监听socket的backlog，默认Socket::kDefaultBacklog，需要在start之前设置
+    // 部署后大量客户端同时重连时，backlog太小会让内核丢弃SYN，客户端要等重传超时
+    void setListenBacklog(int backlog) { listenBacklog_ = backlog; }
+    // 监听socket每次可读最多accept的连接数，见Acceptor::setMaxAcceptsPerWakeup，需要在start之前设置
+    void setMaxAcceptsPerWakeup(int count) { maxAcceptsPerWakeup_ = count; }
+    // 新连接右值send不小于bytes字节时用MSG_ZEROCOPY发送，见TcpConnection::setZeroCopyThreshold
+    // 0表示关闭（默认），需要在start之前设置
+    void setZeroCopyThreshold(size_t bytes) { zeroCopyThreshold_ = bytes; }
+
+    // subloop线程池，start之后可以通过它读取各个loop的运行统计
+    std::shared_ptr<EventLoopThreadPool> threadPool() { return threadPool_; }
+
     // 开启服务器监听
     void start();
 
 private:
+    // 连接按TcpConnection::id()保存，id的表编号：connections_为0，第i个LoopAcceptor为i + 1
+    using ConnectionMap = SlotTable<TcpConnectionPtr>;
+
+    // kReusePort模式下每个subloop独有的监听socket和连接，只在该loop线程中访问
+    struct LoopAcceptor
+    {
+        LoopAcceptor(EventLoop *ioLoop, uint16_t owner): loop(ioLoop), connections(owner) {}
+
+        EventLoop *loop;
+        std::unique_ptr<Acceptor> acceptor;
+        ConnectionMap connections;
+    };
+
     void newConnection(int sockfd, const InetAddress &peerAddr);
+    // 在ioLoop中创建连接对象
+    void newConnectionInLoop(EventLoop *ioLoop, int sockfd, TcpConnection::Id id,
+            const InetAddress &localAddr, const InetAddress &peerAddr);
+    // 把subloop中创建好的连接放进connections_，在baseLoop中执行
+    void addPendingConnections();
+    // 在每个subloop中执行一个空任务并等待，返回时之前投递给它们的任务都已执行完
+    void waitForLoops();
     void removeConnection(const TcpConnectionPtr &conn);
     void removeConnectionInLoop(const TcpConnectionPtr &conn);
 
-private:
-    using ConnectionMap = std::unordered_map<std::string, TcpConnectionPtr>;
+    // kReusePort模式，连接在accept它的subloop中创建和移除
+    void startLoopAcceptors();
+    void newLoopConnection(LoopAcceptor *local, int sockfd, const InetAddress &peerAddr);
+    void removeLoopConnection(LoopAcceptor *local, const TcpConnectionPtr &conn);
+    void configureAcceptor(Acceptor *acceptor);
+
+    // 创建连接对象并设置用户回调，不包括关闭回调
+    TcpConnectionPtr createConnection(EventLoop *ioLoop, int sockfd, TcpConnection::Id id,
+            const InetAddress &localAddr, const InetAddress &peerAddr);
 
     EventLoop *loop_;   // baseLoop 用户定义的loop
+    const InetAddress listenAddr_;
     const std::string ipPort_;
     const std::string name_;
+    const std::shared_ptr<const std::string> connNamePrefix_;  // 所有连接共享的名字前缀
+    const bool reusePort_;
     std::unique_ptr<Acceptor> acceptor_;                // 运行在mainLoop，任务是监听新连接事件
+    std::vector<std::unique_ptr<LoopAcceptor>> loopAcceptors_;  // kReusePort模式下每个subloop一个
     std::shared_ptr<EventLoopThreadPool> threadPool_;   // one loop per thread
 
     ConnectionCallback connectionCallback_;         // 新连接回调
@@ -63,7 +141,19 @@ private:
     ThreadInitCallback threadInitCallback_;         // loop线程初始化回调
 
     std::atomic_int started_;
-    int nextConnId_;
-    ConnectionMap connections_;     // 保存所有的连接
+    double idleTimeout_;
+    bool edgeTriggered_;
+    int socketBusyPollUs_;
+    int lazyWriteDisarm_;
+    bool cpuSteering_;
+    int listenBacklog_;
+    int maxAcceptsPerWakeup_;
+    size_t zeroCopyThreshold_;
+    ConnectionMap connections_;     // 保存所有的连接，kReusePort模式下连接保存在各自的LoopAcceptor中
+    // subloop中创建好、还没有放进connections_的连接，由newConnectionInLoop投递的任务成批取走
+    std::mutex pendingMutex_;
+    std::vector<TcpConnectionPtr> pendingConnections_;
+    // 投递给baseLoop的加入、移除任务持有它的weak_ptr，TcpServer析构之后不再访问this
+    std::shared_ptr<bool> alive_;
 
 };
\ No newline at end of file
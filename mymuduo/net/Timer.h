@@ -0,0 +1,43 @@
+#pragma once
+#include <atomic>
+#include "noncopyable.h"
+#include "Timestamp.h"
+#include "Callbacks.h"
+
+// 定时器，记录超时时间（单调时间）、回调以及重复间隔
+class Timer: noncopyable
+{
+public:
+    Timer(TimerCallback cb, Timestamp when, double interval)
+            : callback_(std::move(cb))
+            , expiration_(when)
+            , interval_(interval)
+            , repeat_(interval > 0.0)
+            , sequence_(++numCreated_)
+            , heapIndex_(-1) {}
+
+    void run() const { callback_(); }
+
+    Timestamp expiration() const { return expiration_; }
+    bool repeat() const { return repeat_; }
+    int64_t sequence() const { return sequence_; }
+
+    // 重复定时器以now为基准重新计算超时时间
+    void restart(Timestamp now);
+
+    // 在TimerQueue最小堆中的下标，-1表示不在堆中
+    int heapIndex() const { return heapIndex_; }
+    void set_heapIndex(int idx) { heapIndex_ = idx; }
+
+    static int64_t numCreated() { return numCreated_; }
+
+private:
+    const TimerCallback callback_;
+    Timestamp expiration_;
+    const double interval_;     // 重复间隔，单位秒
+    const bool repeat_;
+    const int64_t sequence_;    // 全局唯一序号，用来区分地址被复用的定时器
+    int heapIndex_;
+
+    static std::atomic<int64_t> numCreated_;
+};
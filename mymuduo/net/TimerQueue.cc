@@ -0,0 +1,240 @@
+#include "TimerQueue.h"
+#include "Timer.h"
+#include "EventLoop.h"
+#include "Logger.h"
+#include <sys/timerfd.h>
+#include <unistd.h>
+#include <string.h>
+
+static int createTimerfd()
+{
+    // 使用单调时钟，和Timestamp::monotonicNow()保持一致
+    int timerfd = ::timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (timerfd < 0)
+    {
+        LOG_FATAL << "timerfd_create error: " << errno;
+    }
+    return timerfd;
+}
+
+// 堆的比较规则，超时时间相同时按序号先后
+static bool timerLess(const Timer *lhs, const Timer *rhs)
+{
+    if (lhs->expiration() == rhs->expiration())
+    {
+        return lhs->sequence() < rhs->sequence();
+    }
+    return lhs->expiration() < rhs->expiration();
+}
+
+TimerQueue::TimerQueue(EventLoop *loop)
+        : loop_(loop)
+        , timerfd_(createTimerfd())
+        , timerfdChannel_(loop, timerfd_)
+        , callingExpiredTimers_(false)
+{
+    timerfdChannel_.setReadCallback(std::bind(&TimerQueue::handleRead, this));
+    timerfdChannel_.enableReading();
+}
+
+TimerQueue::~TimerQueue()
+{
+    timerfdChannel_.disableAll();
+    timerfdChannel_.remove();
+    ::close(timerfd_);
+    for (auto &item: activeTimers_)
+    {
+        delete item.second;
+    }
+}
+
+TimerId TimerQueue::addTimer(TimerCallback cb, Timestamp when, double interval)
+{
+    Timer *timer = new Timer(std::move(cb), when, interval);
+    loop_->runInLoop(std::bind(&TimerQueue::addTimerInLoop, this, timer));
+    return TimerId(timer, timer->sequence());
+}
+
+void TimerQueue::cancel(TimerId timerId)
+{
+    loop_->runInLoop(std::bind(&TimerQueue::cancelInLoop, this, timerId));
+}
+
+void TimerQueue::addTimerInLoop(Timer *timer)
+{
+    activeTimers_[timer->sequence()] = timer;
+    if (heapPush(timer))
+    {
+        // 新定时器成为最早超时的定时器，需要重新设置timerfd
+        resetTimerfd();
+    }
+}
+
+void TimerQueue::cancelInLoop(TimerId timerId)
+{
+    auto it = activeTimers_.find(timerId.sequence_);
+    if (it == activeTimers_.end())
+    {
+        return;     // 定时器已经超时释放或者已被取消
+    }
+
+    Timer *timer = it->second;
+    if (timer->heapIndex() >= 0)
+    {
+        // 堆顶被删除时不重新设置timerfd，多一次空唤醒也会在handleRead中重新设置
+        heapRemove(timer);
+        activeTimers_.erase(it);
+        delete timer;
+    }
+    else if (callingExpiredTimers_)
+    {
+        // 定时器正在expired_中等待处理，由reset负责释放
+        cancelingTimers_.insert(timerId.sequence_);
+    }
+}
+
+void TimerQueue::handleRead()
+{
+    uint64_t howmany = 0;
+    ssize_t n = ::read(timerfd_, &howmany, sizeof(howmany));
+    if (n != sizeof(howmany))
+    {
+        LOG_ERROR << "TimerQueue::handleRead() reads " << n << " bytes instead of 8";
+    }
+
+    Timestamp now(Timestamp::monotonicNow());
+    getExpired(now);
+
+    callingExpiredTimers_ = true;
+    cancelingTimers_.clear();
+    for (const Timer *timer: expired_)
+    {
+        timer->run();
+    }
+    callingExpiredTimers_ = false;
+
+    reset(now);
+}
+
+void TimerQueue::getExpired(Timestamp now)
+{
+    expired_.clear();
+    while (!heap_.empty() && heap_.front()->expiration() <= now)
+    {
+        Timer *timer = heap_.front();
+        heapRemove(timer);
+        expired_.push_back(timer);
+    }
+}
+
+void TimerQueue::reset(Timestamp now)
+{
+    for (Timer *timer: expired_)
+    {
+        if (timer->repeat() && cancelingTimers_.find(timer->sequence()) == cancelingTimers_.end())
+        {
+            timer->restart(now);
+            heapPush(timer);
+        }
+        else
+        {
+            activeTimers_.erase(timer->sequence());
+            delete timer;
+        }
+    }
+    expired_.clear();
+
+    resetTimerfd();
+}
+
+void TimerQueue::resetTimerfd()
+{
+    if (heap_.empty())
+    {
+        return;
+    }
+
+    // 直接使用单调时钟的绝对时间，已经过期的时间点会让timerfd立即可读
+    int64_t expiration = heap_.front()->expiration().microSecondsSinceEpoch();
+    struct itimerspec newValue;
+    memset(&newValue, 0, sizeof(newValue));
+    newValue.it_value.tv_sec = static_cast<time_t>(expiration / Timestamp::kMicroSecondsPerSecond);
+    newValue.it_value.tv_nsec = static_cast<long>((expiration % Timestamp::kMicroSecondsPerSecond) * 1000);
+    if (::timerfd_settime(timerfd_, TFD_TIMER_ABSTIME, &newValue, nullptr) < 0)
+    {
+        LOG_ERROR << "timerfd_settime error: " << errno;
+    }
+}
+
+bool TimerQueue::heapPush(Timer *timer)
+{
+    int idx = static_cast<int>(heap_.size());
+    heap_.push_back(timer);
+    timer->set_heapIndex(idx);
+    siftUp(idx);
+    return heap_.front() == timer;
+}
+
+void TimerQueue::heapRemove(Timer *timer)
+{
+    int idx = timer->heapIndex();
+    int last = static_cast<int>(heap_.size()) - 1;
+    if (idx != last)
+    {
+        heapSwap(idx, last);
+    }
+    heap_.pop_back();
+    timer->set_heapIndex(-1);
+
+    if (idx < static_cast<int>(heap_.size()))
+    {
+        siftUp(idx);
+        siftDown(idx);
+    }
+}
+
+void TimerQueue::siftUp(int idx)
+{
+    while (idx > 0)
+    {
+        int parent = (idx - 1) / 2;
+        if (!timerLess(heap_[idx], heap_[parent]))
+        {
+            break;
+        }
+        heapSwap(idx, parent);
+        idx = parent;
+    }
+}
+
+void TimerQueue::siftDown(int idx)
+{
+    int size = static_cast<int>(heap_.size());
+    while (true)
+    {
+        int smallest = idx;
+        int left = 2 * idx + 1;
+        int right = left + 1;
+        if (left < size && timerLess(heap_[left], heap_[smallest]))
+        {
+            smallest = left;
+        }
+        if (right < size && timerLess(heap_[right], heap_[smallest]))
+        {
+            smallest = right;
+        }
+        if (smallest == idx)
+        {
+            break;
+        }
+        heapSwap(idx, smallest);
+        idx = smallest;
+    }
+}
+
+void TimerQueue::heapSwap(int i, int j)
+{
+    std::swap(heap_[i], heap_[j]);
+    heap_[i]->set_heapIndex(i);
+    heap_[j]->set_heapIndex(j);
+}
@@ -0,0 +1,66 @@
+#pragma once
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
+#include "noncopyable.h"
+#include "Timestamp.h"
+#include "Callbacks.h"
+#include "Channel.h"
+#include "TimerId.h"
+
+class EventLoop;
+class Timer;
+
+/**
+ * @brief
+ * 定时器队列，每个EventLoop拥有一个，由timerfd驱动
+ * 所有定时器按超时时间（单调时间）组织成数组实现的最小堆，
+ * timerfd只设置为堆顶的超时时间，每次timerfd可读时批量处理所有已超时的定时器
+ */
+class TimerQueue: noncopyable
+{
+public:
+    explicit TimerQueue(EventLoop *loop);
+    ~TimerQueue();
+
+    // 线程安全，when为单调时间，interval大于0表示重复定时器
+    TimerId addTimer(TimerCallback cb, Timestamp when, double interval);
+    // 线程安全
+    void cancel(TimerId timerId);
+
+private:
+    using TimerHeap = std::vector<Timer *>;
+    // key: 定时器序号，用来判断TimerId是否仍然有效
+    using ActiveTimerMap = std::unordered_map<int64_t, Timer *>;
+
+    void addTimerInLoop(Timer *timer);
+    void cancelInLoop(TimerId timerId);
+    // timerfd可读时的回调
+    void handleRead();
+
+    // 取出所有已超时的定时器，放入expired_
+    void getExpired(Timestamp now);
+    // 重复定时器重新入堆，其余的释放
+    void reset(Timestamp now);
+    // 把timerfd设置为堆顶定时器的超时时间
+    void resetTimerfd();
+
+    // 最小堆操作，返回插入后堆顶是否变化
+    bool heapPush(Timer *timer);
+    void heapRemove(Timer *timer);
+    void siftUp(int idx);
+    void siftDown(int idx);
+    void heapSwap(int i, int j);
+
+private:
+    EventLoop *loop_;
+    const int timerfd_;
+    Channel timerfdChannel_;
+
+    TimerHeap heap_;                // 按(超时时间, 序号)排序的最小堆
+    ActiveTimerMap activeTimers_;   // 所有未释放的定时器
+    std::vector<Timer *> expired_;  // 本轮超时的定时器，复用以避免每次分配
+
+    bool callingExpiredTimers_;             // 标识正在执行超时回调
+    std::unordered_set<int64_t> cancelingTimers_;   // 执行超时回调期间被取消的定时器
+};
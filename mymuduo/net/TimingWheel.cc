@@ -0,0 +1,138 @@
+#include "TimingWheel.h"
+#include "EventLoop.h"
+#include "Logger.h"
+#include <math.h>
+
+const double TimingWheel::kDefaultTickSeconds = 1.0;
+
+static int roundUpPowerOfTwo(int n)
+{
+    int size = 1;
+    while (size < n)
+    {
+        size <<= 1;
+    }
+    return size;
+}
+
+TimingWheel::TimingWheel(EventLoop *loop, double tickSeconds, int numSlots)
+        : loop_(loop)
+        , tickSeconds_(tickSeconds)
+        , slots_(roundUpPowerOfTwo(numSlots), nullptr)
+        , mask_(static_cast<int64_t>(slots_.size()) - 1)
+        , currentTick_(0)
+        , size_(0)
+{
+    tickTimer_ = loop_->runEvery(tickSeconds_, std::bind(&TimingWheel::onTick, this));
+}
+
+TimingWheel::~TimingWheel()
+{
+    loop_->cancel(tickTimer_);
+    for (Entry *head: slots_)
+    {
+        while (head)
+        {
+            Entry *next = head->next_;
+            head->wheel_ = nullptr;
+            head->prev_ = head->next_ = nullptr;
+            head->slot_ = -1;
+            head = next;
+        }
+    }
+}
+
+void TimingWheel::add(Entry *entry, double timeoutSeconds)
+{
+    if (entry->wheel_)
+    {
+        unlink(entry);
+    }
+    else
+    {
+        ++size_;
+    }
+
+    // 加入或touch发生在两次tick之间，距离下一次tick可能不到一个tick，
+    // 向上取整后再加一个tick才能保证不会提前淘汰，代价是最多推迟两个tick
+    int64_t ticks = static_cast<int64_t>(::ceil(timeoutSeconds / tickSeconds_));
+    entry->timeoutTicks_ = (ticks > 0 ? ticks : 1) + 1;
+    entry->deadline_ = currentTick_ + entry->timeoutTicks_;
+    entry->wheel_ = this;
+    link(entry, static_cast<int>(entry->deadline_ & mask_));
+}
+
+void TimingWheel::remove(Entry *entry)
+{
+    if (entry->wheel_ == this)
+    {
+        unlink(entry);
+        entry->wheel_ = nullptr;
+        --size_;
+    }
+}
+
+// 每次只处理一个槽，每个节点要么到期，要么被挪到其截止tick所在的槽，
+// 一个节点在一个超时周期内最多被挪动 超时tick数/槽数+1 次，摊还O(1)
+void TimingWheel::onTick()
+{
+    ++currentTick_;
+    const int slot = static_cast<int>(currentTick_ & mask_);
+
+    Entry *entry = slots_[slot];
+    while (entry)
+    {
+        // 回调可能删除链表中的其他节点，所以每次都从槽头取
+        unlink(entry);
+        if (entry->deadline_ <= currentTick_)
+        {
+            entry->wheel_ = nullptr;
+            --size_;
+            if (entry->callback_)
+            {
+                entry->callback_();
+            }
+        }
+        else
+        {
+            int target = static_cast<int>(entry->deadline_ & mask_);
+            if (target == slot)
+            {
+                // 刚好相差整数圈，先放到前一个槽，避免在本轮中重复处理
+                target = static_cast<int>((entry->deadline_ - 1) & mask_);
+            }
+            link(entry, target);
+        }
+        entry = slots_[slot];
+    }
+}
+
+void TimingWheel::link(Entry *entry, int slot)
+{
+    entry->slot_ = slot;
+    entry->prev_ = nullptr;
+    entry->next_ = slots_[slot];
+    if (entry->next_)
+    {
+        entry->next_->prev_ = entry;
+    }
+    slots_[slot] = entry;
+}
+
+void TimingWheel::unlink(Entry *entry)
+{
+    if (entry->prev_)
+    {
+        entry->prev_->next_ = entry->next_;
+    }
+    else
+    {
+        slots_[entry->slot_] = entry->next_;
+    }
+    if (entry->next_)
+    {
+        entry->next_->prev_ = entry->prev_;
+    }
+    entry->prev_ = entry->next_ = nullptr;
+    entry->slot_ = -1;
+}
@@ -0,0 +1,103 @@
+#pragma once
+#include <functional>
+#include <vector>
+#include <stdint.h>
+#include "noncopyable.h"
+#include "TimerId.h"
+
+class EventLoop;
+
+/**
+ * @brief
+ * 哈希时间轮，每个EventLoop最多一个，用来淘汰大量的空闲连接
+ * 时间轮由EventLoop的定时器每tick驱动一次，每个槽是一个侵入式双向链表
+ * 节点（Entry）嵌入在使用者对象中，插入、删除都是O(1)，
+ * touch只更新节点的截止tick，不移动节点；到期检查时若发现截止tick被推后，
+ * 再把节点挪到新的槽里，因此活跃连接的每次读写只需要一次赋值
+ * 所有接口都只能在loop所在线程调用
+ */
+class TimingWheel: noncopyable
+{
+public:
+    using ExpireCallback = std::function<void()>;
+
+    static const int kDefaultNumSlots = 64;
+    static const double kDefaultTickSeconds;
+
+    class Entry: noncopyable
+    {
+    public:
+        Entry()
+                : wheel_(nullptr)
+                , prev_(nullptr)
+                , next_(nullptr)
+                , slot_(-1)
+                , deadline_(0)
+                , timeoutTicks_(0) {}
+        ~Entry() { remove(); }
+
+        void setExpireCallback(ExpireCallback cb) { callback_ = std::move(cb); }
+
+        // 是否在时间轮中
+        bool linked() const { return wheel_ != nullptr; }
+
+        // 有活动时调用，把截止时间推后一个超时周期
+        void touch()
+        {
+            if (wheel_)
+            {
+                deadline_ = wheel_->currentTick() + timeoutTicks_;
+            }
+        }
+
+        // 从时间轮中删除
+        void remove()
+        {
+            if (wheel_)
+            {
+                wheel_->remove(this);
+            }
+        }
+
+    private:
+        friend class TimingWheel;
+
+        TimingWheel *wheel_;
+        Entry *prev_;
+        Entry *next_;
+        int slot_;
+        int64_t deadline_;      // 到期的tick
+        int64_t timeoutTicks_;
+        ExpireCallback callback_;
+    };
+
+    // numSlots会向上取整为2的幂
+    TimingWheel(EventLoop *loop,
+            double tickSeconds = kDefaultTickSeconds,
+            int numSlots = kDefaultNumSlots);
+    ~TimingWheel();
+
+    // 把entry加入时间轮，timeoutSeconds秒内没有touch则执行其回调
+    // 按tick计时，回调在最后一次add/touch之后不早于timeoutSeconds、最多晚两个tick执行
+    void add(Entry *entry, double timeoutSeconds);
+    void remove(Entry *entry);
+
+    int64_t currentTick() const { return currentTick_; }
+    double tickSeconds() const { return tickSeconds_; }
+    size_t size() const { return size_; }
+
+private:
+    // 定时器回调，时间轮前进一格
+    void onTick();
+    void link(Entry *entry, int slot);
+    void unlink(Entry *entry);
+
+private:
+    EventLoop *loop_;
+    const double tickSeconds_;
+    std::vector<Entry *> slots_;    // 每个槽链表的头节点
+    int64_t mask_;
+    int64_t currentTick_;
+    size_t size_;
+    TimerId tickTimer_;
+};
@@ -0,0 +1,335 @@
+#include "UringPoller.h"
+#include "Logger.h"
+#include "Channel.h"
+#include <sys/syscall.h>
+#include <sys/mman.h>
+#include <sys/epoll.h>
+#include <signal.h>
+#include <errno.h>
+#include <unistd.h>
+#include <string.h>
+
+// channel未添加到poller中，channel的成员index_ = -1
+const int kNew = -1;
+// channel已添加到poller中
+const int kAdded = 1;
+
+// POLL_REMOVE等内部请求的user_data，完成事件直接忽略
+static const uint64_t kInternalUserData = 0;
+
+UringPoller::UringPoller(EventLoop *loop)
+        : Poller(loop)
+        , ringfd_(-1)
+        , ringPtr_(MAP_FAILED)
+        , ringSize_(0)
+        , sqes_(static_cast<io_uring_sqe *>(MAP_FAILED))
+        , sqesSize_(0)
+        , sqHead_(nullptr)
+        , sqTail_(nullptr)
+        , sqMask_(0)
+        , sqEntries_(0)
+        , sqeTail_(0)
+        , cqHead_(nullptr)
+        , cqTail_(nullptr)
+        , cqMask_(0)
+        , cqes_(nullptr)
+        , generation_(0)
+        , round_(0)
+{
+    if (!setupRing())
+    {
+        teardownRing();
+    }
+}
+
+UringPoller::~UringPoller()
+{
+    teardownRing();
+}
+
+bool UringPoller::setupRing()
+{
+    io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    ringfd_ = static_cast<int>(::syscall(__NR_io_uring_setup, kRingEntries, &params));
+    if (ringfd_ < 0)
+    {
+        LOG_ERROR << "io_uring_setup error: " << errno;
+        return false;
+    }
+
+    // 需要单次mmap映射两个环（5.4），以及io_uring_enter带超时参数（5.11）
+    if (!(params.features & IORING_FEAT_SINGLE_MMAP) || !(params.features & IORING_FEAT_EXT_ARG))
+    {
+        LOG_ERROR << "io_uring lacks required features: " << params.features;
+        return false;
+    }
+
+    size_t sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    size_t cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    ringSize_ = sqRingSize > cqRingSize ? sqRingSize : cqRingSize;
+    ringPtr_ = ::mmap(nullptr, ringSize_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+            ringfd_, IORING_OFF_SQ_RING);
+    if (ringPtr_ == MAP_FAILED)
+    {
+        LOG_ERROR << "io_uring ring mmap error: " << errno;
+        return false;
+    }
+
+    sqesSize_ = params.sq_entries * sizeof(io_uring_sqe);
+    void *sqes = ::mmap(nullptr, sqesSize_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+            ringfd_, IORING_OFF_SQES);
+    if (sqes == MAP_FAILED)
+    {
+        LOG_ERROR << "io_uring sqes mmap error: " << errno;
+        return false;
+    }
+    sqes_ = static_cast<io_uring_sqe *>(sqes);
+
+    char *ring = static_cast<char *>(ringPtr_);
+    sqHead_ = reinterpret_cast<unsigned *>(ring + params.sq_off.head);
+    sqTail_ = reinterpret_cast<unsigned *>(ring + params.sq_off.tail);
+    sqMask_ = *reinterpret_cast<unsigned *>(ring + params.sq_off.ring_mask);
+    sqEntries_ = *reinterpret_cast<unsigned *>(ring + params.sq_off.ring_entries);
+    sqeTail_ = *sqTail_;
+    // 提交队列的间接数组固定为恒等映射，之后只需要更新tail
+    unsigned *sqArray = reinterpret_cast<unsigned *>(ring + params.sq_off.array);
+    for (unsigned i = 0; i < sqEntries_; i++)
+    {
+        sqArray[i] = i;
+    }
+
+    cqHead_ = reinterpret_cast<unsigned *>(ring + params.cq_off.head);
+    cqTail_ = reinterpret_cast<unsigned *>(ring + params.cq_off.tail);
+    cqMask_ = *reinterpret_cast<unsigned *>(ring + params.cq_off.ring_mask);
+    cqes_ = reinterpret_cast<io_uring_cqe *>(ring + params.cq_off.cqes);
+    return true;
+}
+
+void UringPoller::teardownRing()
+{
+    if (sqes_ != MAP_FAILED)
+    {
+        ::munmap(sqes_, sqesSize_);
+        sqes_ = static_cast<io_uring_sqe *>(MAP_FAILED);
+    }
+    if (ringPtr_ != MAP_FAILED)
+    {
+        ::munmap(ringPtr_, ringSize_);
+        ringPtr_ = MAP_FAILED;
+    }
+    if (ringfd_ >= 0)
+    {
+        ::close(ringfd_);
+        ringfd_ = -1;
+    }
+}
+
+int UringPoller::enter(unsigned toSubmit, unsigned minComplete, unsigned flags, void *arg, size_t argSize)
+{
+    return static_cast<int>(::syscall(__NR_io_uring_enter, ringfd_, toSubmit, minComplete,
+            flags, arg, argSize));
+}
+
+unsigned UringPoller::flushSq()
+{
+    __atomic_store_n(sqTail_, sqeTail_, __ATOMIC_RELEASE);
+    return sqeTail_ - __atomic_load_n(sqHead_, __ATOMIC_ACQUIRE);
+}
+
+io_uring_sqe *UringPoller::getSqe()
+{
+    if (sqeTail_ - __atomic_load_n(sqHead_, __ATOMIC_ACQUIRE) >= sqEntries_)
+    {
+        // 提交队列已满，先提交一批，不等待完成事件
+        if (enter(flushSq(), 0, 0, nullptr, 0) < 0)
+        {
+            LOG_FATAL << "io_uring_enter submit error: " << errno;
+        }
+    }
+
+    io_uring_sqe *sqe = &sqes_[sqeTail_ & sqMask_];
+    memset(sqe, 0, sizeof(*sqe));
+    ++sqeTail_;
+    return sqe;
+}
+
+// 请求先放在提交队列中，和下一次poll()的等待一起提交
+void UringPoller::arm(int fd, PollState *state)
+{
+    Channel *channel = state->channel;
+    state->mask = static_cast<unsigned>(channel->events() & ~EPOLLET);
+    state->multishot = channel->isEdgeTriggered();
+    state->userData = (static_cast<uint64_t>(++generation_) << 32) | static_cast<uint32_t>(fd);
+
+    io_uring_sqe *sqe = getSqe();
+    sqe->opcode = IORING_OP_POLL_ADD;
+    sqe->fd = fd;
+    sqe->poll32_events = state->mask;   // poll与epoll的事件位取值相同
+    sqe->len = state->multishot ? IORING_POLL_ADD_MULTI : 0;
+    sqe->user_data = state->userData;
+}
+
+void UringPoller::disarm(PollState *state)
+{
+    io_uring_sqe *sqe = getSqe();
+    sqe->opcode = IORING_OP_POLL_REMOVE;
+    sqe->fd = -1;
+    sqe->addr = state->userData;
+    sqe->user_data = kInternalUserData;
+    // 之后到达的旧请求的完成事件都会因为userData不匹配而被忽略
+    state->userData = 0;
+}
+
+void UringPoller::rearmFired()
+{
+    for (int fd: fired_)
+    {
+        PollState *state = states_.find(fd);
+        if (state != nullptr
+                && state->userData == 0
+                && !state->channel->isNoneEvent())
+        {
+            arm(fd, state);
+        }
+    }
+    fired_.clear();
+}
+
+Timestamp UringPoller::poll(int timeoutMs, ChannelList *activeChannels)
+{
+    LOG_DEBUG << "func = " << __FUNCTION__ << " -> fd total count: " << channels_.size();
+
+    rearmFired();
+
+    __kernel_timespec ts;
+    ts.tv_sec = timeoutMs / 1000;
+    ts.tv_nsec = (timeoutMs % 1000) * 1000 * 1000;
+    io_uring_getevents_arg arg;
+    memset(&arg, 0, sizeof(arg));
+    arg.sigmask = 0;
+    arg.sigmask_sz = _NSIG / 8;
+    arg.ts = timeoutMs >= 0 ? reinterpret_cast<uint64_t>(&ts) : 0;
+
+    // 一次系统调用完成提交和等待
+    int ret = enter(flushSq(), 1, IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG, &arg, sizeof(arg));
+    int saveErrno = errno;
+    Timestamp now(Timestamp::now());
+
+    int numEvents = reapCompletions(activeChannels);
+    if (numEvents > 0)
+    {
+        LOG_DEBUG << numEvents << " events happened";
+    }
+    else if (ret < 0 && saveErrno != ETIME && saveErrno != EINTR && saveErrno != EBUSY)
+    {
+        errno = saveErrno;
+        LOG_ERROR << "UringPoller::poll() error: " << saveErrno;
+    }
+    return now;
+}
+
+int UringPoller::reapCompletions(ChannelList *activeChannels)
+{
+    ++round_;
+    int numEvents = 0;
+    unsigned head = *cqHead_;
+    unsigned tail = __atomic_load_n(cqTail_, __ATOMIC_ACQUIRE);
+    for (; head != tail; ++head)
+    {
+        const io_uring_cqe &cqe = cqes_[head & cqMask_];
+        if (cqe.user_data == kInternalUserData)
+        {
+            continue;
+        }
+
+        int fd = static_cast<int>(cqe.user_data & 0xffffffff);
+        PollState *it = states_.find(fd);
+        if (it == nullptr || it->userData != cqe.user_data)
+        {
+            continue;   // 已经被取消或替换的请求
+        }
+
+        PollState &state = *it;
+        if (!(cqe.flags & IORING_CQE_F_MORE))
+        {
+            // 单次poll已经返回，或者multishot被内核终止，都需要重新提交
+            state.userData = 0;
+            fired_.push_back(fd);
+        }
+
+        int revents = cqe.res < 0 ? static_cast<int>(EPOLLERR) : cqe.res;
+        Channel *channel = state.channel;
+        if (state.round == round_)
+        {
+            // multishot在同一轮中可能返回多次
+            channel->set_revents(channel->revents() | revents);
+        }
+        else
+        {
+            state.round = round_;
+            channel->set_revents(revents);
+            activeChannels->push_back(channel);
+            ++numEvents;
+        }
+    }
+    __atomic_store_n(cqHead_, head, __ATOMIC_RELEASE);
+    return numEvents;
+}
+
+void UringPoller::updateChannel(Channel *channel)
+{
+    const int fd = channel->fd();
+    LOG_DEBUG << "func = " << __FUNCTION__
+            << " -> fd = " << fd
+            << " events = " << channel->events()
+            << " index = " << channel->index();
+
+    if (channel->index() == kNew)
+    {
+        channels_.insert(fd, channel);
+        PollState state;
+        state.channel = channel;
+        state.userData = 0;
+        state.mask = 0;
+        state.multishot = false;
+        state.round = 0;
+        states_.insert(fd, state);
+        channel->set_index(kAdded);
+    }
+
+    PollState &state = *states_.find(fd);
+    unsigned mask = static_cast<unsigned>(channel->events() & ~EPOLLET);
+    if (state.userData != 0)
+    {
+        if (state.mask == mask && state.multishot == channel->isEdgeTriggered())
+        {
+            return;     // 关注的事件没有变化
+        }
+        disarm(&state);
+    }
+
+    if (!channel->isNoneEvent())
+    {
+        arm(fd, &state);
+    }
+}
+
+void UringPoller::removeChannel(Channel *channel)
+{
+    int fd = channel->fd();
+    channels_.erase(fd);
+
+    LOG_DEBUG << "func = " << __FUNCTION__ << " -> fd = " << fd;
+
+    PollState *state = states_.find(fd);
+    if (state != nullptr)
+    {
+        if (state->userData != 0)
+        {
+            disarm(state);
+        }
+        states_.erase(fd);
+    }
+    channel->set_index(kNew);
+}
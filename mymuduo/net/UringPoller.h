@@ -0,0 +1,81 @@
+#pragma once
+#include <vector>
+#include <linux/io_uring.h>
+#include "Poller.h"
+#include "Timestamp.h"
+#include "FdTable.h"
+
+class Channel;
+
+/**
+ * @brief
+ * 基于io_uring的Poller，直接使用io_uring_setup/io_uring_enter系统调用，不依赖liburing
+ * 每个channel对应一个IORING_OP_POLL_ADD请求：
+ *   - 边缘触发的channel使用multishot poll，注册一次后持续产生完成事件
+ *   - 水平触发的channel使用单次poll，事件返回后在下一次poll()时重新提交，
+ *     重新提交时内核会立即检查当前状态，因此保持了水平触发的语义
+ * 一轮循环中产生的所有POLL_ADD/POLL_REMOVE请求和等待完成事件合并为一次io_uring_enter
+ * 内核不支持io_uring（或缺少所需特性）时valid()返回false，由newDefaultPoller回退到epoll
+ */
+class UringPoller: public Poller
+{
+public:
+    UringPoller(EventLoop *loop);
+    ~UringPoller() override;
+
+    bool valid() const { return ringfd_ >= 0; }
+
+    Timestamp poll(int timeoutMs, ChannelList *activeChannels) override;
+    void updateChannel(Channel *channel) override;
+    void removeChannel(Channel *channel) override;
+
+private:
+    struct PollState
+    {
+        Channel *channel;
+        uint64_t userData;  // 当前poll请求的标识，(代数 << 32) | fd，0表示没有未完成的请求
+        unsigned mask;      // 当前poll请求关注的事件
+        bool multishot;
+        int64_t round;      // 最近一次加入activeChannels的轮次，用来合并同一轮的多个完成事件
+    };
+    using PollStateMap = FdTable<PollState>;
+
+    bool setupRing();
+    void teardownRing();
+
+    io_uring_sqe *getSqe();
+    // 把已填写的提交队列项交给内核，返回待提交的个数
+    unsigned flushSq();
+    int enter(unsigned toSubmit, unsigned minComplete, unsigned flags, void *arg, size_t argSize);
+
+    void arm(int fd, PollState *state);
+    void disarm(PollState *state);
+    void rearmFired();
+    int reapCompletions(ChannelList *activeChannels);
+
+private:
+    static const unsigned kRingEntries = 1024;
+
+    int ringfd_;
+
+    void *ringPtr_;
+    size_t ringSize_;
+    io_uring_sqe *sqes_;
+    size_t sqesSize_;
+
+    unsigned *sqHead_;
+    unsigned *sqTail_;
+    unsigned sqMask_;
+    unsigned sqEntries_;
+    unsigned sqeTail_;      // 本地的提交队列尾，flushSq时写回sqTail_
+
+    unsigned *cqHead_;
+    unsigned *cqTail_;
+    unsigned cqMask_;
+    io_uring_cqe *cqes_;
+
+    uint32_t generation_;
+    int64_t round_;
+    PollStateMap states_;
+    std::vector<int> fired_;    // 单次poll已经返回、需要重新提交的fd
+};
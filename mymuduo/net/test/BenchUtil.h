@@ -0,0 +1,55 @@
+#pragma once
+
+#include "../InetAddress.h"
+
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <unistd.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+// net/test下各bench共用的阻塞客户端辅助函数，出错时直接退出，bench不需要恢复
+
+// 连接到addr，local非空时先绑定本地地址（用来指定源IP）
+inline int connectTo(const InetAddress &addr, const InetAddress *local = nullptr)
+{
+    int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0
+            || (local && ::bind(fd, (const sockaddr *)local->getSockAddr(), sizeof(sockaddr_in)) < 0)
+            || ::connect(fd, (const sockaddr *)addr.getSockAddr(), sizeof(sockaddr_in)) < 0)
+    {
+        perror("connect");
+        exit(1);
+    }
+    return fd;
+}
+
+inline void setTcpNoDelay(int fd)
+{
+    int on = 1;
+    ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+}
+
+// close时发RST，避免客户端积累大量TIME_WAIT耗尽端口
+inline void setRstOnClose(int fd)
+{
+    linger lin = {1, 0};
+    ::setsockopt(fd, SOL_SOCKET, SO_LINGER, &lin, sizeof(lin));
+}
+
+// 读满len字节，对端关闭或出错时返回false
+inline bool readFull(int fd, char *buf, size_t len)
+{
+    size_t got = 0;
+    while (got < len)
+    {
+        ssize_t n = ::read(fd, buf + got, len - got);
+        if (n <= 0)
+        {
+            return false;
+        }
+        got += n;
+    }
+    return true;
+}
@@ -0,0 +1,109 @@
+#include "../TcpServer.h"
+#include "../../base/Logger.h"
+#include "BenchUtil.h"
+
+#include <sys/socket.h>
+#include <unistd.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+// 新连接的接受速率：baseLoop统一accept再转交subloop，对比每个subloop各自accept（kReusePort）
+// 多个客户端线程不停地建立连接并立即关闭，服务端收到连接后立即关闭
+// 同时输出各subloop收到的跨线程回调数，即baseLoop转交连接的次数
+// 用法: accept_bench <single|reuseport|steer> [threads=4] [clients=4] [seconds=3]
+
+static const uint16_t kPort = 9986;
+
+int main(int argc, char *argv[])
+{
+    if (argc < 2)
+    {
+        fprintf(stderr, "usage: %s <single|reuseport|steer> [threads] [clients] [seconds]\n", argv[0]);
+        return 1;
+    }
+    std::string mode = argv[1];
+    int numThreads = argc > 2 ? atoi(argv[2]) : 4;
+    int numClients = argc > 3 ? atoi(argv[3]) : 4;
+    int seconds = argc > 4 ? atoi(argv[4]) : 3;
+    if (mode != "single" && mode != "reuseport" && mode != "steer")
+    {
+        fprintf(stderr, "unknown mode %s\n", mode.c_str());
+        return 1;
+    }
+
+    Logger::setOutputFunc([](const char *, size_t) {});
+    Logger::setLogLevel(Logger::ERROR);
+
+    EventLoop loop;
+    InetAddress addr(kPort);
+    TcpServer server(&loop, addr, "AcceptBench",
+            mode == "single" ? TcpServer::kNoReusePort : TcpServer::kReusePort);
+    server.setThreadNum(numThreads);
+    server.setReusePortCpuSteering(mode == "steer");
+    std::atomic<int64_t> accepted(0);
+    server.setConnectionCallback([&](const TcpConnectionPtr &conn)
+    {
+        if (conn->connected())
+        {
+            ++accepted;
+            conn->forceClose();
+        }
+    });
+    server.setMessageCallback([](const TcpConnectionPtr &, Buffer *buf, Timestamp)
+    {
+        buf->retrieveAll();
+    });
+    server.start();
+
+    std::atomic_bool stop(false);
+    std::vector<std::thread> clients;
+    for (int i = 0; i < numClients; i++)
+    {
+        clients.emplace_back([&]()
+        {
+            while (!stop)
+            {
+                int fd = connectTo(addr);
+                // 等服务端关闭，避免客户端积压过多连接
+                char c;
+                ::read(fd, &c, 1);
+                ::close(fd);
+            }
+        });
+    }
+
+    std::vector<EventLoop *> loops = server.threadPool()->getAllLoops();
+    std::vector<uint64_t> remoteBefore;
+    for (EventLoop *ioLoop: loops)
+    {
+        remoteBefore.push_back(ioLoop->stats().remoteFunctors);
+    }
+    int64_t acceptedBefore = accepted;
+    Timestamp start(Timestamp::monotonicNow());
+    std::thread timer([&]()
+    {
+        ::sleep(seconds);
+        stop = true;
+        for (std::thread &client: clients)
+        {
+            client.join();
+        }
+        loop.quit();
+    });
+    loop.loop();
+    timer.join();
+
+    double elapsed = timeDifference(Timestamp::monotonicNow(), start);
+    printf("mode=%s threads=%d clients=%d: %.0f conns/s\n",
+            mode.c_str(), numThreads, numClients, (accepted - acceptedBefore) / elapsed);
+    for (size_t i = 0; i < loops.size(); i++)
+    {
+        printf("  loop %zu: cross-thread functors=%lu\n",
+                i, static_cast<unsigned long>(loops[i]->stats().remoteFunctors - remoteBefore[i]));
+    }
+    return 0;
+}
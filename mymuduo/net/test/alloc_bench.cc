@@ -0,0 +1,271 @@
+#include "../TcpServer.h"
+#include "../EventLoopThread.h"
+#include "../Channel.h"
+#include "../../base/Logger.h"
+#include "../../base/CountDownLatch.h"
+#include "BenchUtil.h"
+
+#include <sys/socket.h>
+#include <unistd.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <vector>
+#include <atomic>
+#include <new>
+
+// 统计连接建立、跨线程投递回调、跨线程send路径上的内存分配次数
+// 替换全局的operator new，进程内所有线程的分配都会被计数，
+// 因此每个阶段都先预热，计数期间除被测路径外所有loop都是空闲的
+// 投递和发送都按kBatch一批进行，等loop处理完再投递下一批，模拟有界的在途回调数；
+// 回调节点池的大小等于在途回调数的峰值，无界地投递只是在测试池的增长
+// 用法: alloc_bench
+
+static std::atomic<int64_t> g_allocs(0);
+
+void *operator new(size_t size)
+{
+    g_allocs.fetch_add(1, std::memory_order_relaxed);
+    void *p = ::malloc(size ? size : 1);
+    if (p == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void operator delete(void *p) noexcept
+{
+    ::free(p);
+}
+
+void operator delete(void *p, size_t) noexcept
+{
+    ::free(p);
+}
+
+static const uint16_t kPort = 9983;
+static const int kPosts = 100000;
+static const int kConns = 200;
+static const int kSends = 20032;    // kBatch的整数倍
+static const size_t kMessageSize = 64;
+static const int kBatch = 64;
+
+// 和TcpConnection的成员函数回调形状相同：成员函数指针 + shared_ptr/this + 参数
+struct Target: std::enable_shared_from_this<Target>
+{
+    void established() { ++calls; }
+    void sendString(const std::string &message) { calls += message.size(); }
+    void handleRead(Timestamp) { ++calls; }
+    int64_t calls = 0;
+};
+
+template<typename Function, typename Factory>
+static double allocsPerCall(Factory &&make)
+{
+    const int kIterations = 10000;
+    int64_t before = g_allocs.load();
+    for (int i = 0; i < kIterations; i++)
+    {
+        Function f(make());
+        Function g(std::move(f));   // 进入队列或回调槽时至少移动一次
+        g();
+    }
+    return static_cast<double>(g_allocs.load() - before) / kIterations;
+}
+
+static void compareCallables()
+{
+    auto target = std::make_shared<Target>();
+    std::string message(kMessageSize, 'x');
+    Timestamp now(Timestamp::now());
+
+    printf("%-40s %16s %16s\n", "callable", "std::function", "InplaceFunction");
+    auto connectShape = [&]() { return std::bind(&Target::established, target); };
+    printf("%-40s %16.2f %16.2f\n", "bind(memfn, shared_ptr)",
+            allocsPerCall<std::function<void()>>(connectShape),
+            allocsPerCall<EventLoop::Functor>(connectShape));
+
+    // 这里先拷贝一份字符串，两种实现都包含这一次分配
+    auto sendShape = [&]() { return std::bind(&Target::sendString, target, message); };
+    printf("%-40s %16.2f %16.2f\n", "bind(memfn, shared_ptr, string)",
+            allocsPerCall<std::function<void()>>(sendShape),
+            allocsPerCall<EventLoop::Functor>(sendShape));
+
+    auto readShape = [&]()
+    {
+        return std::bind(std::bind(&Target::handleRead, target.get(), std::placeholders::_1), now);
+    };
+    printf("%-40s %16.2f %16.2f\n", "Channel read callback",
+            allocsPerCall<std::function<void()>>(readShape),
+            allocsPerCall<Channel::EventCallback>(readShape));
+}
+
+// 其他线程向loop投递与connectEstablished形状相同的回调
+static double crossThreadPost()
+{
+    EventLoopThread loopThread;
+    EventLoop *loop = loopThread.startLoop();
+    auto target = std::make_shared<Target>();
+
+    auto post = [&](int n)
+    {
+        for (int posted = 0; posted < n; posted += kBatch)
+        {
+            CountDownLatch done(1);
+            for (int i = 0; i < kBatch; i++)
+            {
+                loop->runInLoop(std::bind(&Target::established, target));
+            }
+            loop->runInLoop([&done]() { done.countDown(); });
+            done.wait();
+        }
+    };
+
+    post(kPosts);   // 预热，填满回调节点缓存
+    int64_t before = g_allocs.load();
+    post(kPosts);
+    return static_cast<double>(g_allocs.load() - before) / kPosts;
+}
+
+// 连接建立的分配次数，以及在其他线程对已建立的连接调用send的分配次数
+static void serverPaths()
+{
+    EventLoopThread loopThread;
+    EventLoop *loop = loopThread.startLoop();
+    InetAddress addr(kPort);
+
+    std::vector<TcpConnectionPtr> conns;
+    std::atomic_int numConnected(0);
+    std::atomic_int numClosed(0);
+    std::atomic_bool keepConns(false);
+    TcpServer *server = nullptr;
+    CountDownLatch created(1);
+    loop->runInLoop([&]()
+    {
+        server = new TcpServer(loop, addr, "AllocBench");
+        server->setThreadNum(1);
+        server->setConnectionCallback([&](const TcpConnectionPtr &conn)
+        {
+            if (!conn->connected())
+            {
+                ++numClosed;
+            }
+            else if (keepConns)
+            {
+                conns.push_back(conn);  // 预留了容量，不会分配
+                ++numConnected;
+            }
+        });
+        server->setMessageCallback([](const TcpConnectionPtr &, Buffer *buf, Timestamp)
+        {
+            buf->retrieveAll();
+        });
+        server->start();
+        created.countDown();
+    });
+    created.wait();
+    conns.reserve(2 * kConns + 1);
+
+    auto connectBatch = [&](int n, std::vector<int> *fds)
+    {
+        int target = numConnected + n;
+        for (int i = 0; i < n; i++)
+        {
+            fds->push_back(connectTo(addr));
+        }
+        while (numConnected < target)
+        {
+            ::usleep(100);
+        }
+    };
+
+    // 连接建立后客户端立即关闭，统计一次建立+关闭的分配次数和连接内存池的命中率
+    EventLoop *ioLoop = server->threadPool()->getAllLoops().front();
+    auto churn = [&](int n)
+    {
+        int target = numClosed + n;
+        for (int i = 0; i < n; i++)
+        {
+            ::close(connectTo(addr));
+        }
+        while (numClosed < target)
+        {
+            ::usleep(100);
+        }
+    };
+    for (int i = 0; i < 5; i++)
+    {
+        churn(kConns);  // 预热，池增长到并发连接数的峰值
+    }
+    EventLoopStats::Snapshot poolBefore = ioLoop->stats();
+    int64_t before = g_allocs.load();
+    churn(kConns);
+    EventLoopStats::Snapshot poolAfter = ioLoop->stats();
+    uint64_t hits = poolAfter.poolHits - poolBefore.poolHits;
+    uint64_t misses = poolAfter.poolMisses - poolBefore.poolMisses;
+    printf("connection churn (accept to close): %.2f allocs/conn, pool hit rate %.1f%% (%lu hits, %lu misses)\n",
+            static_cast<double>(g_allocs.load() - before) / kConns,
+            hits + misses > 0 ? 100.0 * hits / (hits + misses) : 0.0,
+            static_cast<unsigned long>(hits), static_cast<unsigned long>(misses));
+
+    keepConns = true;
+    std::vector<int> fds;
+    fds.reserve(2 * kConns + 1);
+    connectBatch(kConns, &fds);     // 预热
+    before = g_allocs.load();
+    connectBatch(kConns, &fds);
+    printf("connection setup (accept to connected): %.2f allocs/conn\n",
+            static_cast<double>(g_allocs.load() - before) / kConns);
+
+    // 消息预先构造好，计数只包含send本身
+    std::vector<std::string> messages(2 * kSends, std::string(kMessageSize, 'm'));
+    TcpConnectionPtr conn = conns.back();
+    int fd = fds.back();
+    std::vector<char> buf(kMessageSize * kBatch);
+    auto sendBatches = [&](int first, int n)
+    {
+        for (int sent = 0; sent < n; sent += kBatch)
+        {
+            for (int i = 0; i < kBatch; i++)
+            {
+                conn->send(std::move(messages[first + sent + i]));
+            }
+            if (!readFull(fd, buf.data(), buf.size()))
+            {
+                perror("read");
+                exit(1);
+            }
+        }
+    };
+    sendBatches(0, kSends);     // 预热
+    before = g_allocs.load();
+    sendBatches(kSends, kSends);
+    printf("cross-thread send(std::string&&): %.2f allocs/send\n",
+            static_cast<double>(g_allocs.load() - before) / kSends);
+
+    conn.reset();
+    for (int fd: fds)
+    {
+        ::close(fd);
+    }
+    CountDownLatch destroyed(1);
+    loop->runInLoop([&]()
+    {
+        conns.clear();
+        delete server;
+        destroyed.countDown();
+    });
+    destroyed.wait();
+}
+
+int main()
+{
+    Logger::setOutputFunc([](const char *, size_t) {});
+    Logger::setLogLevel(Logger::ERROR);
+
+    compareCallables();
+    printf("\ncross-thread runInLoop(bind(memfn, shared_ptr)): %.2f allocs/post\n", crossThreadPost());
+    serverPaths();
+    return 0;
+}
@@ -0,0 +1,155 @@
+#include "../TcpServer.h"
+#include "../../base/Logger.h"
+#include "BenchUtil.h"
+
+#include <sys/socket.h>
+#include <unistd.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+// 倾斜负载下各分配策略的loop负载均衡程度
+// 每kLoops个连接中有一个重连接（持续发送，服务端按字节做计算），其余是轻连接（偶尔发一条小消息）
+// 连接依次间隔kArrivalMs到达，第i个客户端从127.0.0.(i+1)发起连接，使kPeerHash有不同的对端IP
+// 输出每个loop的连接数和运行期间的忙碌时间，max/mean越接近1越均衡，所有重连接都在同一个loop时约为kLoops
+// 用法: balance_bench <rr|conns|busy|hash> [seconds=3]
+
+static const uint16_t kPort = 9985;
+static const int kLoops = 4;
+static const int kConns = 16;
+static const int kArrivalMs = 120;
+static const size_t kHeavyChunk = 16 * 1024;
+
+static volatile uint64_t g_sink = 0;
+
+// 模拟按字节处理请求的计算量
+static void process(const char *data, size_t len)
+{
+    uint64_t h = g_sink;
+    for (int round = 0; round < 8; round++)
+    {
+        for (size_t i = 0; i < len; i++)
+        {
+            h = h * 131 + static_cast<unsigned char>(data[i]);
+        }
+    }
+    g_sink = h;
+}
+
+static int connectFrom(int i, const InetAddress &serverAddr)
+{
+    char ip[32];
+    snprintf(ip, sizeof(ip), "127.0.0.%d", i + 1);
+    InetAddress local(0, ip);
+    return connectTo(serverAddr, &local);
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc < 2)
+    {
+        fprintf(stderr, "usage: %s <rr|conns|busy|hash> [seconds]\n", argv[0]);
+        return 1;
+    }
+    std::string policy = argv[1];
+    int seconds = argc > 2 ? atoi(argv[2]) : 3;
+
+    Logger::setOutputFunc([](const char *, size_t) {});
+    Logger::setLogLevel(Logger::ERROR);
+
+    EventLoop loop;
+    InetAddress addr(kPort);
+    TcpServer server(&loop, addr, "BalanceBench");
+    server.setThreadNum(kLoops);
+    if (policy == "conns")
+    {
+        server.setLoadBalance(EventLoopThreadPool::kLeastConnections);
+    }
+    else if (policy == "busy")
+    {
+        server.setLoadBalance(EventLoopThreadPool::kLeastBusy);
+    }
+    else if (policy == "hash")
+    {
+        server.setLoadBalance(EventLoopThreadPool::kPeerHash);
+    }
+    else if (policy != "rr")
+    {
+        fprintf(stderr, "unknown policy %s\n", policy.c_str());
+        return 1;
+    }
+    server.setConnectionCallback([](const TcpConnectionPtr &) {});
+    server.setMessageCallback([](const TcpConnectionPtr &, Buffer *buf, Timestamp)
+    {
+        process(buf->peek(), buf->readableBytes());
+        buf->retrieveAll();
+    });
+    server.start();
+
+    std::vector<EventLoop *> loops = server.threadPool()->getAllLoops();
+    std::vector<uint64_t> busyBefore;
+    for (EventLoop *ioLoop: loops)
+    {
+        busyBefore.push_back(ioLoop->busyMicroSeconds());
+    }
+
+    std::atomic_bool stop(false);
+    std::vector<std::thread> clients;
+    std::vector<int> connsPerLoop(loops.size());
+    std::thread driver([&]()
+    {
+        for (int i = 0; i < kConns; i++)
+        {
+            bool heavy = (i % kLoops == 0);
+            clients.emplace_back([&, i, heavy]()
+            {
+                int fd = connectFrom(i, addr);
+                std::string chunk(heavy ? kHeavyChunk : 100, 'b');
+                while (!stop)
+                {
+                    if (::write(fd, chunk.data(), chunk.size()) <= 0)
+                    {
+                        break;
+                    }
+                    if (!heavy)
+                    {
+                        ::usleep(10 * 1000);
+                    }
+                }
+                ::close(fd);
+            });
+            ::usleep(kArrivalMs * 1000);
+        }
+        ::sleep(seconds);
+        for (size_t i = 0; i < loops.size(); i++)
+        {
+            connsPerLoop[i] = loops[i]->numConnections();
+        }
+        stop = true;
+        for (std::thread &client: clients)
+        {
+            client.join();
+        }
+        loop.quit();
+    });
+    loop.loop();
+    driver.join();
+
+    uint64_t maxBusy = 0;
+    uint64_t totalBusy = 0;
+    printf("policy=%s\n", policy.c_str());
+    for (size_t i = 0; i < loops.size(); i++)
+    {
+        uint64_t busy = loops[i]->busyMicroSeconds() - busyBefore[i];
+        maxBusy = std::max(maxBusy, busy);
+        totalBusy += busy;
+        printf("  loop %zu: connections=%d busy=%.1f ms\n",
+                i, connsPerLoop[i], busy / 1000.0);
+    }
+    printf("  busy max/mean = %.2f\n", static_cast<double>(maxBusy) * loops.size() / (totalBusy > 0 ? totalBusy : 1));
+    return 0;
+}
@@ -0,0 +1,118 @@
+#include "../Buffer.h"
+#include "../ChainBuffer.h"
+#include "../../base/Timestamp.h"
+
+#include <sys/uio.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+
+// Buffer和ChainBuffer作为发送缓冲区的开销，不涉及系统调用，只比较缓冲区本身
+//   small    每次追加一条小消息后全部取走，连接不积压时的常见情况
+//   grow     从空开始追加到backlog字节再全部取走，突发的大量发送
+//   backlog  稳定积压backlog字节：每轮追加一条消息，积压超出一次"写出"的量（256KB，模拟内核发送缓冲区）时取走256KB，
+//            Buffer可写空间用完时会把全部积压数据搬回头部，ChainBuffer只挂新块
+// 输出每追加1GB数据所用的时间
+// 用法: buffer_bench [backlogMB=64] [msgKB=64]
+
+static const size_t kWriteChunk = 256 * 1024;
+
+template<typename Append, typename Drain>
+static double run(const char *name, size_t totalBytes, Append append, Drain drain)
+{
+    Timestamp start(Timestamp::monotonicNow());
+    size_t appended = 0;
+    while (appended < totalBytes)
+    {
+        appended += append();
+        drain();
+    }
+    double seconds = timeDifference(Timestamp::monotonicNow(), start);
+    double msPerGB = seconds * 1000 / (static_cast<double>(appended) / (1 << 30));
+    printf("  %-8s %10.1f ms/GB\n", name, msPerGB);
+    return msPerGB;
+}
+
+int main(int argc, char *argv[])
+{
+    size_t backlog = (argc > 1 ? atoi(argv[1]) : 64) * 1024 * 1024;
+    size_t msgSize = (argc > 2 ? atoi(argv[2]) : 64) * 1024;
+    std::string msg(msgSize, 'm');
+    std::string small(100, 's');
+    const size_t total = 4ULL << 30;
+    unsigned long long checksum = 0;
+    struct iovec iov[IOV_MAX];
+
+    printf("small (100B append, drain all):\n");
+    {
+        Buffer buf;
+        run("Buffer", total / 16, [&]() { buf.append(small); return small.size(); },
+                [&]() { checksum += *buf.peek(); buf.retrieveAll(); });
+        ChainBuffer chain;
+        run("Chain", total / 16, [&]() { chain.append(small); return small.size(); },
+                [&]() { checksum += chain.fillIovec(iov, IOV_MAX); chain.retrieveAll(); });
+    }
+
+    printf("grow (append %zuKB until %zuMB, then drain all):\n", msgSize >> 10, backlog >> 20);
+    {
+        // 每次都用新的缓冲区，和新连接第一次积压的情况一样
+        auto growBuffer = [&]()
+        {
+            Buffer buf;
+            while (buf.readableBytes() < backlog)
+            {
+                buf.append(msg);
+            }
+            checksum += *buf.peek();
+            return buf.readableBytes();
+        };
+        auto growChain = [&]()
+        {
+            ChainBuffer chain;
+            while (chain.readableBytes() < backlog)
+            {
+                chain.append(msg);
+            }
+            checksum += chain.fillIovec(iov, IOV_MAX);
+            return chain.readableBytes();
+        };
+        run("Buffer", total, growBuffer, []() {});
+        run("Chain", total, growChain, []() {});
+    }
+
+    printf("backlog (steady %zuMB backlog, append %zuKB, write out %zuKB):\n",
+            backlog >> 20, msgSize >> 10, kWriteChunk >> 10);
+    {
+        Buffer buf;
+        while (buf.readableBytes() < backlog)
+        {
+            buf.append(msg);
+        }
+        run("Buffer", total, [&]() { buf.append(msg); return msg.size(); }, [&]()
+        {
+            if (buf.readableBytes() >= backlog + kWriteChunk)
+            {
+                checksum += *buf.peek();
+                buf.retrieve(kWriteChunk);
+            }
+        });
+
+        ChainBuffer chain;
+        while (chain.readableBytes() < backlog)
+        {
+            chain.append(msg);
+        }
+        run("Chain", total, [&]() { chain.append(msg); return msg.size(); }, [&]()
+        {
+            if (chain.readableBytes() >= backlog + kWriteChunk)
+            {
+                checksum += chain.fillIovec(iov, IOV_MAX, kWriteChunk);
+                chain.retrieve(kWriteChunk);
+            }
+        });
+    }
+
+    printf("(checksum %llu)\n", checksum);
+    return 0;
+}
@@ -0,0 +1,260 @@
+#include "../TcpServer.h"
+#include "../EventLoopThread.h"
+#include "../FdTable.h"
+#include "../SlotTable.h"
+#include "../../base/Logger.h"
+#include "../../base/CountDownLatch.h"
+#include "BenchUtil.h"
+
+#include <sys/socket.h>
+#include <unistd.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <atomic>
+
+// 连接的建立和关闭开销
+// 第一部分只比较Poller中channel表的开销：按accept/close的方式反复插入、查找、删除fd，
+//   unordered_map<int, Channel*>（原实现）对比FdTable<Channel*>（现实现）
+// 第二部分比较TcpServer中连接表的开销：建立时生成名字并插入、关闭时删除，
+//   snprintf名字 + unordered_map<string, TcpConnectionPtr>（原实现）对比SlotTable<TcpConnectionPtr>（现实现）
+// 第三部分是端到端的连接抖动：客户端保持kLiveConns个长连接，
+//   同时不停地新建短连接并立即关闭，统计服务端每秒完成的建立+关闭次数
+// 用法: churn_bench [秒数]
+
+static const uint16_t kPort = 9982;
+static const int kLiveConns = 1000;
+
+// 模拟服务端的fd分配：总是复用最小的空闲fd，同时存在live个连接
+template<typename Table>
+static double tableChurn(Table &table, int live, int64_t iterations)
+{
+    Channel *dummy = reinterpret_cast<Channel *>(&table);
+    const int base = 16;
+    for (int fd = base; fd < base + live; fd++)
+    {
+        table.insert(fd, dummy);
+    }
+
+    uint64_t found = 0;
+    Timestamp start(Timestamp::monotonicNow());
+    for (int64_t i = 0; i < iterations; i++)
+    {
+        int fd = base + static_cast<int>((i * 7919) % live);
+        table.erase(fd);                // 连接关闭
+        table.insert(fd, dummy);        // 新连接复用同一个fd
+        found += table.find(fd) != nullptr;  // hasChannel
+    }
+    double elapsed = timeDifference(Timestamp::monotonicNow(), start);
+    if (found != static_cast<uint64_t>(iterations))
+    {
+        printf("lookup mismatch\n");
+    }
+    return elapsed * 1e9 / iterations;
+}
+
+// 给unordered_map套上和FdTable相同的接口
+struct HashTable
+{
+    std::unordered_map<int, Channel *> map;
+    void insert(int fd, Channel *channel) { map[fd] = channel; }
+    void erase(int fd) { map.erase(fd); }
+    Channel **find(int fd)
+    {
+        auto it = map.find(fd);
+        return it == map.end() ? nullptr : &it->second;
+    }
+};
+
+// 原实现：每个连接格式化一个名字，按名字插入和删除
+static double nameMapChurn(int live, int64_t iterations)
+{
+    std::unordered_map<std::string, TcpConnectionPtr> map;
+    std::vector<std::string> names(live);
+    int64_t nextId = 1;
+    auto add = [&](int i)
+    {
+        char buf[64];
+        snprintf(buf, sizeof(buf), "-%s#%ld", "127.0.0.1:8000", static_cast<long>(nextId++));
+        names[i] = std::string("ChurnBench") + buf;
+        map[names[i]] = TcpConnectionPtr();
+    };
+    for (int i = 0; i < live; i++)
+    {
+        add(i);
+    }
+
+    Timestamp start(Timestamp::monotonicNow());
+    for (int64_t i = 0; i < iterations; i++)
+    {
+        int k = static_cast<int>((i * 7919) % live);
+        map.erase(names[k]);    // 连接关闭
+        add(k);                 // 新连接
+    }
+    double elapsed = timeDifference(Timestamp::monotonicNow(), start);
+    if (map.size() != static_cast<size_t>(live))
+    {
+        printf("size mismatch\n");
+    }
+    return elapsed * 1e9 / iterations;
+}
+
+// 现实现：按64位id插入和删除，名字只在打印日志时生成
+static double slotTableChurn(int live, int64_t iterations)
+{
+    SlotTable<TcpConnectionPtr> table;
+    std::vector<SlotTable<TcpConnectionPtr>::Id> ids(live);
+    for (int i = 0; i < live; i++)
+    {
+        ids[i] = table.insert(TcpConnectionPtr());
+    }
+
+    Timestamp start(Timestamp::monotonicNow());
+    for (int64_t i = 0; i < iterations; i++)
+    {
+        int k = static_cast<int>((i * 7919) % live);
+        table.erase(ids[k]);
+        ids[k] = table.insert(TcpConnectionPtr());
+    }
+    double elapsed = timeDifference(Timestamp::monotonicNow(), start);
+    if (table.size() != static_cast<size_t>(live))
+    {
+        printf("size mismatch\n");
+    }
+    return elapsed * 1e9 / iterations;
+}
+
+class ChurnServer
+{
+public:
+    ChurnServer(EventLoop *loop, const InetAddress &addr)
+            : server_(loop, addr, "ChurnBench")
+            , numConnected_(0)
+            , numClosed_(0)
+    {
+        server_.setConnectionCallback([this](const TcpConnectionPtr &conn)
+        {
+            if (conn->connected())
+            {
+                ++numConnected_;
+            }
+            else
+            {
+                --numConnected_;
+                ++numClosed_;
+            }
+        });
+        server_.setMessageCallback([](const TcpConnectionPtr &, Buffer *buf, Timestamp)
+        {
+            buf->retrieveAll();
+        });
+        server_.start();
+    }
+
+    int numConnected() const { return numConnected_; }
+    int64_t numClosed() const { return numClosed_; }
+
+private:
+    TcpServer server_;
+    std::atomic_int numConnected_;
+    std::atomic<int64_t> numClosed_;
+};
+
+// 返回服务端每秒完成的连接建立+关闭次数
+static double serverChurn(double seconds)
+{
+    EventLoopThread loopThread;
+    EventLoop *loop = loopThread.startLoop();
+    InetAddress addr(kPort);
+
+    ChurnServer *server = nullptr;
+    CountDownLatch created(1);
+    loop->runInLoop([&]()
+    {
+        server = new ChurnServer(loop, addr);
+        created.countDown();
+    });
+    created.wait();
+
+    std::vector<int> live;
+    for (int i = 0; i < kLiveConns; i++)
+    {
+        live.push_back(connectTo(addr));
+        setRstOnClose(live.back());
+    }
+    while (server->numConnected() < kLiveConns)
+    {
+        ::usleep(1000);
+    }
+
+    int64_t closedBefore = server->numClosed();
+    Timestamp start(Timestamp::monotonicNow());
+    double elapsed = 0.0;
+    int64_t opened = 0;
+    while (elapsed < seconds)
+    {
+        int fd = connectTo(addr);
+        setRstOnClose(fd);
+        ::close(fd);
+        ++opened;
+        // 不让积压过多，否则测的是backlog
+        while (opened - (server->numClosed() - closedBefore) > 64)
+        {
+            ::sched_yield();
+        }
+        elapsed = timeDifference(Timestamp::monotonicNow(), start);
+    }
+    while (server->numClosed() - closedBefore < opened)
+    {
+        ::usleep(1000);
+    }
+    elapsed = timeDifference(Timestamp::monotonicNow(), start);
+
+    for (int fd: live)
+    {
+        ::close(fd);
+    }
+    while (server->numConnected() > 0)
+    {
+        ::usleep(1000);
+    }
+
+    CountDownLatch destroyed(1);
+    loop->runInLoop([&]()
+    {
+        delete server;
+        destroyed.countDown();
+    });
+    destroyed.wait();
+    return opened / elapsed;
+}
+
+int main(int argc, char *argv[])
+{
+    Logger::setOutputFunc([](const char *, size_t) {});
+    double seconds = argc > 1 ? atof(argv[1]) : 2.0;
+
+    const int64_t kIterations = 10 * 1000 * 1000;
+    const int liveCounts[] = {100, 10000, 100000};
+    printf("%-16s %8s %12s\n", "channel table", "live fds", "ns/churn");
+    for (int live: liveCounts)
+    {
+        HashTable hash;
+        FdTable<Channel *> dense;
+        printf("%-16s %8d %12.1f\n", "unordered_map", live, tableChurn(hash, live, kIterations));
+        printf("%-16s %8d %12.1f\n", "FdTable", live, tableChurn(dense, live, kIterations));
+    }
+
+    printf("\n%-16s %8s %12s\n", "connection table", "live", "ns/churn");
+    for (int live: liveCounts)
+    {
+        printf("%-16s %8d %12.1f\n", "name + map", live, nameMapChurn(live, kIterations / 4));
+        printf("%-16s %8d %12.1f\n", "SlotTable", live, slotTableChurn(live, kIterations / 4));
+    }
+
+    printf("\n%d live connections, server side accept + close: %.0f conns/s\n",
+            kLiveConns, serverChurn(seconds));
+    return 0;
+}
@@ -0,0 +1,177 @@
+#include "../TcpServer.h"
+#include "../../base/CpuAffinity.h"
+#include "../../base/Logger.h"
+#include "../../base/CountDownLatch.h"
+#include "BenchUtil.h"
+
+#include <sys/socket.h>
+#include <unistd.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <atomic>
+#include <fstream>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+// 不同绑核策略下echo服务器的吞吐，以及期间各NUMA节点的numastat变化
+// 策略：
+//   none   不绑核
+//   cores  每个subloop独占一个物理核，客户端不绑核
+//   local  subloop绑定到节点0，客户端也绑定到节点0
+//   cross  subloop绑定到节点0，客户端绑定到最后一个节点，数据在节点之间往返
+// other_node、numa_miss增长说明有内存分配落到了远端节点
+// 单节点机器上local和cross相同，只能看到绑核本身的影响
+// 用法: numa_bench <none|cores|local|cross> [threads=2] [conns=4] [seconds=5] [msgKB=16]
+
+static const uint16_t kPort = 9984;
+
+using NumaStat = std::map<std::string, long long>;
+
+static NumaStat readNumaStat(int node)
+{
+    NumaStat stat;
+    char path[128];
+    snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/numastat", node);
+    std::ifstream in(path);
+    std::string key;
+    long long value = 0;
+    while (in >> key >> value)
+    {
+        stat[key] = value;
+    }
+    return stat;
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc < 2)
+    {
+        fprintf(stderr, "usage: %s <none|cores|local|cross> [threads] [conns] [seconds] [msgKB]\n", argv[0]);
+        return 1;
+    }
+    std::string policy = argv[1];
+    int numThreads = argc > 2 ? atoi(argv[2]) : 2;
+    int numConns = argc > 3 ? atoi(argv[3]) : 4;
+    int seconds = argc > 4 ? atoi(argv[4]) : 5;
+    size_t msgSize = (argc > 5 ? atoi(argv[5]) : 16) * 1024;
+
+    Logger::setOutputFunc([](const char *, size_t) {});
+    Logger::setLogLevel(Logger::ERROR);
+
+    std::vector<int> nodes = CpuAffinity::numaNodes();
+    std::vector<int> clientCpus;
+    EventLoop loop;
+    InetAddress addr(kPort);
+    TcpServer server(&loop, addr, "NumaBench");
+    server.setThreadNum(numThreads);
+    if (policy == "cores")
+    {
+        server.setThreadAffinity(EventLoopThreadPool::kPhysicalCore);
+    }
+    else if (policy == "local" || policy == "cross")
+    {
+        server.setThreadAffinity(EventLoopThreadPool::kNumaNode, std::vector<int>(1, nodes.front()));
+        clientCpus = CpuAffinity::nodeCpus(policy == "local" ? nodes.front() : nodes.back());
+    }
+    else if (policy != "none")
+    {
+        fprintf(stderr, "unknown policy %s\n", policy.c_str());
+        return 1;
+    }
+    server.setConnectionCallback([](const TcpConnectionPtr &) {});
+    server.setMessageCallback([](const TcpConnectionPtr &conn, Buffer *buf, Timestamp)
+    {
+        conn->send(buf->retrieveAllAsString());
+    });
+    server.start();
+
+    printf("policy=%s threads=%d conns=%d msg=%zuKB nodes=%zu\n",
+            policy.c_str(), numThreads, numConns, msgSize / 1024, nodes.size());
+    for (EventLoop *ioLoop: server.threadPool()->getAllLoops())
+    {
+        CountDownLatch latch(1);
+        int cpu = -1;
+        ioLoop->runInLoop([&]()
+        {
+            cpu = CpuAffinity::currentCpu();
+            latch.countDown();
+        });
+        latch.wait();
+        printf("  loop %p on cpu %d (node %d)\n", ioLoop, cpu, CpuAffinity::nodeOfCpu(cpu));
+    }
+
+    std::vector<NumaStat> before;
+    for (int node: nodes)
+    {
+        before.push_back(readNumaStat(node));
+    }
+
+    std::atomic_bool stop(false);
+    std::atomic<long long> roundTrips(0);
+    std::vector<std::thread> clients;
+    Timestamp start(Timestamp::monotonicNow());
+    for (int i = 0; i < numConns; i++)
+    {
+        clients.emplace_back([&]()
+        {
+            if (!clientCpus.empty())
+            {
+                CpuAffinity::bindCurrentThread(clientCpus);
+            }
+            int fd = connectTo(addr);
+            setTcpNoDelay(fd);
+            std::vector<char> message(msgSize, 'n');
+            std::vector<char> reply(msgSize);
+            while (!stop)
+            {
+                if (::write(fd, message.data(), msgSize) != static_cast<ssize_t>(msgSize))
+                {
+                    perror("write");
+                    exit(1);
+                }
+                if (!readFull(fd, reply.data(), msgSize))
+                {
+                    perror("read");
+                    exit(1);
+                }
+                ++roundTrips;
+            }
+            ::close(fd);
+        });
+    }
+
+    std::thread timer([&]()
+    {
+        ::sleep(seconds);
+        stop = true;
+        for (std::thread &client: clients)
+        {
+            client.join();
+        }
+        loop.quit();
+    });
+    loop.loop();
+    timer.join();
+
+    double elapsed = timeDifference(Timestamp::monotonicNow(), start);
+    long long n = roundTrips.load();
+    printf("round trips: %lld (%.0f/s), echo throughput %.1f MB/s, avg rtt %.1f us\n",
+            n, n / elapsed, 2.0 * n * msgSize / elapsed / (1 << 20),
+            elapsed * 1e6 * numConns / (n > 0 ? n : 1));
+
+    printf("numastat delta (pages):\n");
+    for (size_t i = 0; i < nodes.size(); i++)
+    {
+        NumaStat after = readNumaStat(nodes[i]);
+        printf("  node%d:", nodes[i]);
+        for (const auto &item: after)
+        {
+            printf(" %s=%lld", item.first.c_str(), item.second - before[i][item.first]);
+        }
+        printf("\n");
+    }
+    return 0;
+}
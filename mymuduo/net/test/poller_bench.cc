@@ -0,0 +1,189 @@
+#include "../TcpServer.h"
+#include "../EventLoopThread.h"
+#include "../../base/Logger.h"
+#include "../../base/CountDownLatch.h"
+#include "BenchUtil.h"
+
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include <atomic>
+
+// 用example/testserver.cc的echo负载（不主动关闭连接）比较不同Poller后端
+// 建立N个连接，客户端每次向其中kBatch个连接各写一条消息再逐个读回，
+// 连接总数越多，每次poll需要扫描/维护的fd越多
+// 用法: poller_bench [秒数] [后端...]，后端为epoll、poll、uring
+
+static const int kBatch = 64;
+static const int kMessageSize = 64;
+static const uint16_t kPort = 9981;
+
+class EchoServer
+{
+public:
+    EchoServer(EventLoop *loop, const InetAddress &addr)
+            : server_(loop, addr, "PollerBench")
+            , numConnected_(0)
+    {
+        server_.setConnectionCallback([this](const TcpConnectionPtr &conn)
+        {
+            if (conn->connected())
+            {
+                ++numConnected_;
+            }
+            else
+            {
+                --numConnected_;
+            }
+        });
+        server_.setMessageCallback([](const TcpConnectionPtr &conn, Buffer *buf, Timestamp)
+        {
+            conn->send(buf->retrieveAllAsString());
+        });
+        server_.start();
+    }
+
+    int numConnected() const { return numConnected_; }
+
+private:
+    TcpServer server_;
+    std::atomic_int numConnected_;
+};
+
+static void selectBackend(const std::string &backend)
+{
+    ::unsetenv("MUDUO_USE_POLL");
+    ::unsetenv("MUDUO_USE_URING");
+    if (backend == "poll")
+    {
+        ::setenv("MUDUO_USE_POLL", "1", 1);
+    }
+    else if (backend == "uring")
+    {
+        ::setenv("MUDUO_USE_URING", "1", 1);
+    }
+}
+
+// 返回每秒完成的往返次数
+static double runOne(const std::string &backend, int numConns, double seconds)
+{
+    selectBackend(backend);
+    EventLoopThread loopThread;
+    EventLoop *loop = loopThread.startLoop();   // 在新线程中按环境变量创建Poller
+    InetAddress addr(kPort);
+
+    // TcpServer的创建和析构都放在loop线程中
+    EchoServer *server = nullptr;
+    CountDownLatch created(1);
+    loop->runInLoop([&]()
+    {
+        server = new EchoServer(loop, addr);
+        created.countDown();
+    });
+    created.wait();
+
+    std::vector<int> fds;
+    fds.reserve(numConns);
+    for (int i = 0; i < numConns; i++)
+    {
+        fds.push_back(connectTo(addr));
+        setTcpNoDelay(fds.back());
+    }
+    while (server->numConnected() < numConns)
+    {
+        ::usleep(1000);
+    }
+
+    char message[kMessageSize];
+    memset(message, 'x', sizeof(message));
+    char reply[kMessageSize];
+    const int batch = numConns < kBatch ? numConns : kBatch;
+
+    int64_t roundTrips = 0;
+    size_t next = 0;
+    Timestamp start(Timestamp::monotonicNow());
+    double elapsed = 0.0;
+    while (elapsed < seconds)
+    {
+        // 轮流使用所有连接，使每个fd都真正参与
+        size_t first = next;
+        for (int i = 0; i < batch; i++)
+        {
+            ::write(fds[(first + i) % fds.size()], message, sizeof(message));
+        }
+        for (int i = 0; i < batch; i++)
+        {
+            if (!readFull(fds[(first + i) % fds.size()], reply, sizeof(reply)))
+            {
+                perror("read");
+                exit(1);
+            }
+        }
+        next = (first + batch) % fds.size();
+        roundTrips += batch;
+        elapsed = timeDifference(Timestamp::monotonicNow(), start);
+    }
+
+    for (int fd: fds)
+    {
+        ::close(fd);
+    }
+    while (server->numConnected() > 0)
+    {
+        ::usleep(1000);
+    }
+
+    CountDownLatch destroyed(1);
+    loop->runInLoop([&]()
+    {
+        delete server;
+        destroyed.countDown();
+    });
+    destroyed.wait();
+    return roundTrips / elapsed;
+}
+
+int main(int argc, char *argv[])
+{
+    Logger::setOutputFunc([](const char *, size_t) {});
+
+    double seconds = argc > 1 ? atof(argv[1]) : 2.0;
+    std::vector<std::string> backends;
+    for (int i = 2; i < argc; i++)
+    {
+        backends.push_back(argv[i]);
+    }
+    if (backends.empty())
+    {
+        backends = {"epoll", "poll", "uring"};
+    }
+
+    // 客户端和服务端都在本进程内，每个连接占用两个fd
+    rlimit rl;
+    ::getrlimit(RLIMIT_NOFILE, &rl);
+    rl.rlim_cur = rl.rlim_max;
+    ::setrlimit(RLIMIT_NOFILE, &rl);
+    const int maxConns = static_cast<int>((rl.rlim_cur - 64) / 2);
+
+    const int connCounts[] = {10, 1000, 50000};
+    printf("%-8s %8s %16s\n", "backend", "conns", "round trips/s");
+    for (int wanted: connCounts)
+    {
+        int numConns = wanted < maxConns ? wanted : maxConns;
+        if (numConns < wanted)
+        {
+            printf("# %d connections capped to %d by RLIMIT_NOFILE\n", wanted, numConns);
+        }
+        for (const std::string &backend: backends)
+        {
+            double rate = runOne(backend, numConns, seconds);
+            printf("%-8s %8d %16.0f\n", backend.c_str(), numConns, rate);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,172 @@
+#include "../TcpServer.h"
+#include "../../base/Logger.h"
+#include "BenchUtil.h"
+
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+// 静态文件的发送吞吐：客户端每发一个字节的请求，服务端回复 头部 + 文件内容 + 尾部
+//   copy      HttpServer原来的做法：mmap文件，拷贝到string作为body，序列化到Buffer，再拷贝成string发送
+//   sendfile  头部send，文件内容用TcpConnection::sendFile，尾部send
+// 客户端校验每个回复的头部、文件内容和尾部，验证文件段与前后数据的顺序
+// 用法: sendfile_bench <copy|sendfile> [fileMB=16] [clients=2] [seconds=3] [et]
+
+static const uint16_t kPort = 9987;
+static const char kHeader[] = "HTTP/1.1 200 OK\r\n\r\n";
+static const char kTrailer[] = "--end--";
+
+static char patternAt(size_t i)
+{
+    return static_cast<char>('a' + i % 23);
+}
+
+static std::string createFile(size_t size)
+{
+    char path[] = "/tmp/sendfile_bench_XXXXXX";
+    int fd = ::mkstemp(path);
+    if (fd < 0)
+    {
+        perror("mkstemp");
+        exit(1);
+    }
+    std::vector<char> data(size);
+    for (size_t i = 0; i < size; i++)
+    {
+        data[i] = patternAt(i);
+    }
+    if (::write(fd, data.data(), size) != static_cast<ssize_t>(size))
+    {
+        perror("write");
+        exit(1);
+    }
+    ::close(fd);
+    return path;
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc < 2)
+    {
+        fprintf(stderr, "usage: %s <copy|sendfile> [fileMB] [clients] [seconds] [et]\n", argv[0]);
+        return 1;
+    }
+    std::string mode = argv[1];
+    size_t fileSize = (argc > 2 ? atoi(argv[2]) : 16) * 1024 * 1024;
+    int numClients = argc > 3 ? atoi(argv[3]) : 2;
+    int seconds = argc > 4 ? atoi(argv[4]) : 3;
+    bool et = argc > 5 && std::string(argv[5]) == "et";
+    if (mode != "copy" && mode != "sendfile")
+    {
+        fprintf(stderr, "unknown mode %s\n", mode.c_str());
+        return 1;
+    }
+
+    Logger::setOutputFunc([](const char *, size_t) {});
+    Logger::setLogLevel(Logger::ERROR);
+
+    std::string path = createFile(fileSize);
+    EventLoop loop;
+    InetAddress addr(kPort);
+    TcpServer server(&loop, addr, "SendfileBench");
+    server.setThreadNum(2);
+    server.setEdgeTriggered(et);
+    server.setConnectionCallback([](const TcpConnectionPtr &) {});
+    server.setMessageCallback([&](const TcpConnectionPtr &conn, Buffer *buf, Timestamp)
+    {
+        size_t requests = buf->readableBytes();
+        buf->retrieveAll();
+        for (size_t i = 0; i < requests; i++)
+        {
+            int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+            if (mode == "sendfile")
+            {
+                conn->send(std::string(kHeader));
+                conn->sendFile(fd, 0, fileSize);
+                conn->send(std::string(kTrailer));
+            }
+            else
+            {
+                void *mapped = ::mmap(nullptr, fileSize, PROT_READ, MAP_PRIVATE, fd, 0);
+                std::string body(static_cast<const char *>(mapped), fileSize);
+                ::munmap(mapped, fileSize);
+                Buffer response;
+                response.append(kHeader, strlen(kHeader));
+                response.append(body.data(), body.size());
+                response.append(kTrailer, strlen(kTrailer));
+                conn->send(std::string(response.peek(), response.readableBytes()));
+            }
+            ::close(fd);
+        }
+    });
+    server.start();
+
+    std::atomic_bool stop(false);
+    std::atomic<int64_t> responses(0);
+    std::atomic_bool corrupted(false);
+    std::vector<std::thread> clients;
+    Timestamp start(Timestamp::monotonicNow());
+    for (int c = 0; c < numClients; c++)
+    {
+        clients.emplace_back([&]()
+        {
+            int fd = connectTo(addr);
+            size_t headerLen = strlen(kHeader);
+            size_t trailerLen = strlen(kTrailer);
+            std::vector<char> reply(headerLen + fileSize + trailerLen);
+            bool verify = true;     // 只完整校验第一个回复，之后只校验头尾，避免客户端成为瓶颈
+            while (!stop)
+            {
+                if (::write(fd, "g", 1) != 1 || !readFull(fd, reply.data(), reply.size()))
+                {
+                    corrupted = true;
+                    break;
+                }
+                bool ok = memcmp(reply.data(), kHeader, headerLen) == 0
+                        && memcmp(reply.data() + headerLen + fileSize, kTrailer, trailerLen) == 0;
+                for (size_t i = 0; verify && ok && i < fileSize; i++)
+                {
+                    ok = reply[headerLen + i] == patternAt(i);
+                }
+                verify = false;
+                if (!ok)
+                {
+                    corrupted = true;
+                    break;
+                }
+                ++responses;
+            }
+            ::close(fd);
+        });
+    }
+
+    std::thread timer([&]()
+    {
+        ::sleep(seconds);
+        stop = true;
+        for (std::thread &client: clients)
+        {
+            client.join();
+        }
+        loop.quit();
+    });
+    loop.loop();
+    timer.join();
+    ::unlink(path.c_str());
+
+    double elapsed = timeDifference(Timestamp::monotonicNow(), start);
+    printf("mode=%s%s file=%zuMB clients=%d: %lld responses, %.1f MB/s%s\n",
+            mode.c_str(), et ? "(et)" : "", fileSize >> 20, numClients,
+            static_cast<long long>(responses.load()),
+            responses.load() * static_cast<double>(fileSize) / elapsed / (1 << 20),
+            corrupted ? ", CORRUPTED" : "");
+    return corrupted ? 1 : 0;
+}
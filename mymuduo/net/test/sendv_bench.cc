@@ -0,0 +1,146 @@
+#include "../TcpServer.h"
+#include "../../base/Logger.h"
+#include "BenchUtil.h"
+
+#include <sys/uio.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+// 协议头和消息体分开存放时的发送开销：客户端每发一个字节的请求，服务端回复 头部 + 消息体
+//   concat  HttpServer原来的做法：头部和消息体追加到Buffer，再拷贝成string发送
+//   sendv   头部和消息体作为两段交给TcpConnection::sendv，直接writev
+// 客户端校验每个回复的头部，第一个回复完整校验消息体
+// 用法: sendv_bench <concat|sendv> [bodyKB=64] [clients=2] [seconds=3] [et]
+
+static const uint16_t kPort = 9989;
+static const char kHeader[] = "HTTP/1.1 200 OK\r\nContent-Type: application/octet-stream\r\n\r\n";
+
+static char patternAt(size_t i)
+{
+    return static_cast<char>('a' + i % 23);
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc < 2)
+    {
+        fprintf(stderr, "usage: %s <concat|sendv> [bodyKB] [clients] [seconds] [et]\n", argv[0]);
+        return 1;
+    }
+    std::string mode = argv[1];
+    size_t bodySize = (argc > 2 ? atoi(argv[2]) : 64) * 1024;
+    int numClients = argc > 3 ? atoi(argv[3]) : 2;
+    int seconds = argc > 4 ? atoi(argv[4]) : 3;
+    bool et = argc > 5 && std::string(argv[5]) == "et";
+    if (mode != "concat" && mode != "sendv")
+    {
+        fprintf(stderr, "unknown mode %s\n", mode.c_str());
+        return 1;
+    }
+
+    Logger::setOutputFunc([](const char *, size_t) {});
+    Logger::setLogLevel(Logger::ERROR);
+
+    std::string body(bodySize, 0);
+    for (size_t i = 0; i < bodySize; i++)
+    {
+        body[i] = patternAt(i);
+    }
+    const size_t headerLen = strlen(kHeader);
+
+    EventLoop loop;
+    InetAddress addr(kPort);
+    TcpServer server(&loop, addr, "SendvBench");
+    server.setThreadNum(2);
+    server.setEdgeTriggered(et);
+    server.setConnectionCallback([](const TcpConnectionPtr &) {});
+    server.setMessageCallback([&](const TcpConnectionPtr &conn, Buffer *buf, Timestamp)
+    {
+        size_t requests = buf->readableBytes();
+        buf->retrieveAll();
+        for (size_t i = 0; i < requests; i++)
+        {
+            if (mode == "sendv")
+            {
+                struct iovec iov[2];
+                iov[0].iov_base = const_cast<char *>(kHeader);
+                iov[0].iov_len = headerLen;
+                iov[1].iov_base = const_cast<char *>(body.data());
+                iov[1].iov_len = body.size();
+                conn->sendv(iov, 2);
+            }
+            else
+            {
+                Buffer response;
+                response.append(kHeader, headerLen);
+                response.append(body.data(), body.size());
+                conn->send(std::string(response.peek(), response.readableBytes()));
+            }
+        }
+    });
+    server.start();
+
+    std::atomic_bool stop(false);
+    std::atomic<int64_t> responses(0);
+    std::atomic_bool corrupted(false);
+    std::vector<std::thread> clients;
+    Timestamp start(Timestamp::monotonicNow());
+    for (int c = 0; c < numClients; c++)
+    {
+        clients.emplace_back([&]()
+        {
+            int fd = connectTo(addr);
+            std::vector<char> reply(headerLen + bodySize);
+            bool verify = true;     // 只完整校验第一个回复，避免客户端成为瓶颈
+            while (!stop)
+            {
+                if (::write(fd, "g", 1) != 1 || !readFull(fd, reply.data(), reply.size()))
+                {
+                    corrupted = true;
+                    break;
+                }
+                bool ok = memcmp(reply.data(), kHeader, headerLen) == 0;
+                for (size_t i = 0; verify && ok && i < bodySize; i++)
+                {
+                    ok = reply[headerLen + i] == patternAt(i);
+                }
+                verify = false;
+                if (!ok)
+                {
+                    corrupted = true;
+                    break;
+                }
+                ++responses;
+            }
+            ::close(fd);
+        });
+    }
+
+    std::thread timer([&]()
+    {
+        ::sleep(seconds);
+        stop = true;
+        for (std::thread &client: clients)
+        {
+            client.join();
+        }
+        loop.quit();
+    });
+    loop.loop();
+    timer.join();
+
+    double elapsed = timeDifference(Timestamp::monotonicNow(), start);
+    printf("mode=%s%s body=%zuKB clients=%d: %lld responses, %.0f responses/s, %.1f MB/s%s\n",
+            mode.c_str(), et ? "(et)" : "", bodySize >> 10, numClients,
+            static_cast<long long>(responses.load()), responses.load() / elapsed,
+            responses.load() * static_cast<double>(bodySize) / elapsed / (1 << 20),
+            corrupted ? ", CORRUPTED" : "");
+    return corrupted ? 1 : 0;
+}
@@ -0,0 +1,192 @@
+#include "../TcpServer.h"
+#include "../../base/Logger.h"
+#include "BenchUtil.h"
+
+#include <sys/uio.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+// sendv/sendFile与普通send混合时的顺序和完整性
+// 客户端一次性发出kReplies个一字节的请求，服务端对第i个请求回复
+//   "H%07d"(send) + 若干段(sendv，偶数i用vector<string>，奇数i用iovec) [+ 文件(sendFile)] + "T"(send)
+// 每10个回复中有一个带2000段，超过IOV_MAX，要分多次writev
+// cross时每个回复在另一个线程发出，走跨线程排队的路径
+// 客户端读完后与期望的字节流逐字节比较，不一致时打印第一个不同的位置并返回1
+// 用法: sendv_test [et] [cross]
+
+static const uint16_t kPort = 9990;
+static const int kReplies = 200;
+static const size_t kFileSize = 20000;
+static const char kFilePath[] = "/tmp/sendv_test_file";
+
+static std::string segment(int i, int k, size_t len)
+{
+    std::string s(len, 0);
+    for (size_t j = 0; j < len; j++)
+    {
+        s[j] = static_cast<char>((j * 13 + k * 7 + i) & 0xff);
+    }
+    return s;
+}
+
+static int numSegments(int i)
+{
+    return i % 10 == 3 ? 2000 : 3;
+}
+
+static size_t segmentLen(int i, int k)
+{
+    if (i % 10 == 3)
+    {
+        return 500 + (k % 7) * 1000;
+    }
+    return k == 1 ? 9000 : 100 + k;
+}
+
+static bool withFile(int i)
+{
+    return i % 4 == 1;
+}
+
+static std::string header(int i)
+{
+    char buf[16];
+    snprintf(buf, sizeof(buf), "H%07d", i);
+    return buf;
+}
+
+static std::string expectedReply(int i)
+{
+    std::string s = header(i);
+    for (int k = 0; k < numSegments(i); k++)
+    {
+        s += segment(i, k, segmentLen(i, k));
+    }
+    if (withFile(i))
+    {
+        s += segment(0, 99, kFileSize);
+    }
+    return s + "T";
+}
+
+static void reply(const TcpConnectionPtr &conn, int i)
+{
+    conn->send(header(i));
+    std::vector<std::string> segments;
+    for (int k = 0; k < numSegments(i); k++)
+    {
+        segments.push_back(segment(i, k, segmentLen(i, k)));
+    }
+    if (i % 2 == 0)
+    {
+        conn->sendv(std::move(segments));
+    }
+    else
+    {
+        // iovec版本在返回前已经把没发完的数据拷贝走，segments可以在这之后析构
+        std::vector<struct iovec> iov(segments.size());
+        for (size_t k = 0; k < segments.size(); k++)
+        {
+            iov[k].iov_base = &segments[k][0];
+            iov[k].iov_len = segments[k].size();
+        }
+        conn->sendv(iov.data(), static_cast<int>(iov.size()));
+    }
+    if (withFile(i))
+    {
+        int fd = ::open(kFilePath, O_RDONLY | O_CLOEXEC);
+        conn->sendFile(fd, 0, kFileSize);
+        ::close(fd);
+    }
+    conn->send(std::string("T"));
+}
+
+int main(int argc, char *argv[])
+{
+    bool edgeTriggered = false;
+    bool cross = false;
+    for (int i = 1; i < argc; i++)
+    {
+        edgeTriggered = edgeTriggered || strcmp(argv[i], "et") == 0;
+        cross = cross || strcmp(argv[i], "cross") == 0;
+    }
+    Logger::setLogLevel(Logger::ERROR);
+
+    std::string file = segment(0, 99, kFileSize);
+    int fileFd = ::open(kFilePath, O_CREAT | O_TRUNC | O_WRONLY | O_CLOEXEC, 0644);
+    if (fileFd < 0 || ::write(fileFd, file.data(), file.size()) != static_cast<ssize_t>(file.size()))
+    {
+        perror("write file");
+        return 1;
+    }
+    ::close(fileFd);
+
+    EventLoop loop;
+    InetAddress addr(kPort);
+    TcpServer server(&loop, addr, "sendv_test");
+    server.setThreadNum(1);
+    server.setEdgeTriggered(edgeTriggered);
+    server.setConnectionCallback([](const TcpConnectionPtr &) {});
+    int next = 0;   // 只在唯一的subloop中访问
+    server.setMessageCallback([&](const TcpConnectionPtr &conn, Buffer *buf, Timestamp)
+    {
+        size_t n = buf->readableBytes();
+        buf->retrieveAll();
+        for (size_t r = 0; r < n; r++)
+        {
+            int i = next++;
+            if (cross)
+            {
+                std::thread([conn, i]() { reply(conn, i); }).join();
+            }
+            else
+            {
+                reply(conn, i);
+            }
+        }
+    });
+    server.start();
+
+    std::atomic_bool ok(false);
+    std::thread client([&]()
+    {
+        std::string expected;
+        for (int i = 0; i < kReplies; i++)
+        {
+            expected += expectedReply(i);
+        }
+        int fd = connectTo(addr);
+        std::string requests(kReplies, 'g');
+        ::write(fd, requests.data(), requests.size());
+        std::string got(expected.size(), 0);
+        bool complete = readFull(fd, &got[0], got.size());
+        ok = complete && got == expected;
+        if (!ok)
+        {
+            size_t pos = 0;
+            while (pos < got.size() && got[pos] == expected[pos])
+            {
+                pos++;
+            }
+            printf("FAILED: %s, first difference at byte %zu of %zu\n",
+                    complete ? "corrupted" : "connection closed early", pos, expected.size());
+        }
+        else
+        {
+            printf("OK: %d replies, %zu bytes\n", kReplies, got.size());
+        }
+        ::close(fd);
+        loop.quit();
+    });
+    loop.loop();
+    client.join();
+    ::unlink(kFilePath);
+    return ok ? 0 : 1;
+}
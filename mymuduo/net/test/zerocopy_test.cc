@@ -0,0 +1,133 @@
+#include "../TcpServer.h"
+#include "../../base/Logger.h"
+#include "BenchUtil.h"
+
+#include <unistd.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+// 零拷贝send与普通send交错时的顺序和完整性
+// 客户端一次性发出kReplies个一字节的请求，服务端对第i个请求回复
+//   "H%07d"(拷贝) + kBigSize字节的第i个样式(右值send，超过阈值走MSG_ZEROCOPY) + "T"(拷贝)
+// 最后一个回复在另一个线程发出后调用shutdown，验证零拷贝数据发完（不必等完成通知）之后才关闭写端
+// cross时每个回复都在另一个线程发出
+// 客户端读到EOF后逐个校验回复，输出零拷贝的发送/完成次数，失败时返回1
+// 用法: zerocopy_test [et] [cross]
+
+static const uint16_t kPort = 9991;
+static const int kReplies = 200;
+static const size_t kBigSize = 200 * 1024;
+static const size_t kReplySize = 8 + kBigSize + 1;
+
+static std::string bigMessage(int i)
+{
+    std::string s(kBigSize, 0);
+    for (size_t k = 0; k < kBigSize; k++)
+    {
+        s[k] = static_cast<char>((k * 7 + i) & 0xff);
+    }
+    return s;
+}
+
+static std::string header(int i)
+{
+    char buf[16];
+    snprintf(buf, sizeof(buf), "H%07d", i);
+    return buf;
+}
+
+static void reply(const TcpConnectionPtr &conn, int i)
+{
+    conn->send(header(i));
+    conn->send(bigMessage(i));
+    conn->send(std::string("T"));
+    if (i == kReplies - 1)
+    {
+        conn->shutdown();
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    bool edgeTriggered = false;
+    bool cross = false;
+    for (int i = 1; i < argc; i++)
+    {
+        edgeTriggered = edgeTriggered || strcmp(argv[i], "et") == 0;
+        cross = cross || strcmp(argv[i], "cross") == 0;
+    }
+    Logger::setLogLevel(Logger::ERROR);
+
+    EventLoop loop;
+    InetAddress addr(kPort);
+    TcpServer server(&loop, addr, "zerocopy_test");
+    server.setThreadNum(1);
+    server.setEdgeTriggered(edgeTriggered);
+    server.setZeroCopyThreshold(64 * 1024);
+    server.setConnectionCallback([](const TcpConnectionPtr &) {});
+    int next = 0;   // 只在唯一的subloop中访问
+    server.setMessageCallback([&](const TcpConnectionPtr &conn, Buffer *buf, Timestamp)
+    {
+        size_t n = buf->readableBytes();
+        buf->retrieveAll();
+        for (size_t r = 0; r < n; r++)
+        {
+            int i = next++;
+            if (cross || i == kReplies - 1)
+            {
+                std::thread([conn, i]() { reply(conn, i); }).join();
+            }
+            else
+            {
+                reply(conn, i);
+            }
+        }
+    });
+    server.start();
+
+    std::atomic_bool ok(false);
+    std::thread client([&]()
+    {
+        int fd = connectTo(addr);
+        std::string requests(kReplies, 'g');
+        ::write(fd, requests.data(), requests.size());
+        std::vector<char> got;
+        std::vector<char> buf(64 * 1024);
+        ssize_t n;
+        while ((n = ::read(fd, buf.data(), buf.size())) > 0)
+        {
+            got.insert(got.end(), buf.data(), buf.data() + n);
+        }
+        bool good = got.size() == kReplies * kReplySize;
+        for (int i = 0; good && i < kReplies; i++)
+        {
+            const char *p = got.data() + i * kReplySize;
+            good = memcmp(p, header(i).data(), 8) == 0
+                    && memcmp(p + 8, bigMessage(i).data(), kBigSize) == 0
+                    && p[8 + kBigSize] == 'T';
+            if (!good)
+            {
+                printf("FAILED: reply %d corrupted\n", i);
+            }
+        }
+        printf("%s: got %zu bytes before EOF, expected %zu\n",
+                good ? "OK" : "FAILED", got.size(), kReplies * kReplySize);
+        ok = good;
+        ::close(fd);
+        loop.quit();
+    });
+    loop.loop();
+    client.join();
+
+    EventLoopStats::Snapshot stats = server.threadPool()->getAllLoops()[0]->stats();
+    printf("zerocopy sends %lu completions %lu copied %lu\n",
+            static_cast<unsigned long>(stats.zeroCopySends),
+            static_cast<unsigned long>(stats.zeroCopyCompletions),
+            static_cast<unsigned long>(stats.zeroCopyCopied));
+    return ok ? 0 : 1;
+}